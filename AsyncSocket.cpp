@@ -0,0 +1,155 @@
+#include "AsyncSocket.h"
+//c headers
+#include <sys/socket.h>
+//cpp headers
+#include <algorithm>
+#include <exception>
+#include <string_view>
+#include <vector>
+//own headers
+#include "ServerSocket.h"
+#include "SnlException.h"
+#include "SocketAddress.h"
+
+namespace snl{
+
+    namespace{
+        //eagerly started coroutine that destroys itself when it completes
+        struct DetachedTask{
+            struct promise_type{
+                DetachedTask get_return_object() const noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept { }
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+        };
+
+        DetachedTask runDetached(Task<> task){
+            try{
+                co_await task;
+            }catch(SnlException&){
+                //nobody awaits the task, a failing connection just ends it
+            }
+        }
+    }
+
+    void spawn(Task<> task){
+        runDetached(std::move(task));
+    }
+
+    Task<std::size_t> asyncSend(EventLoop& loop, StreamSocket& strSock, const void* buffer, std::size_t bufferSize, int flags){
+        strSock.setNonBlockIO(true);
+        std::size_t bytesSent = 0;
+        while(!strSock.trySend(buffer, bufferSize, bytesSent, flags)){
+            co_await writable(loop, strSock.getFd());
+        }
+        co_return bytesSent;
+    }
+
+    Task<std::size_t> asyncReceive(EventLoop& loop, StreamSocket& strSock, void* buffer, std::size_t bufferSize, int flags){
+        strSock.setNonBlockIO(true);
+        std::size_t bytesReceived = 0;
+        while(!strSock.tryReceive(buffer, bufferSize, bytesReceived, flags)){
+            co_await readable(loop, strSock.getFd());
+        }
+        co_return bytesReceived;
+    }
+
+    Task<StreamSocket> asyncConnect(EventLoop& loop, const SocketAddress& sockAddr){
+        StreamSocket strSock;
+        strSock.setNonBlockIO(true);
+        if(!strSock.beginConnect(sockAddr)){
+            co_await writable(loop, strSock.getFd());
+            strSock.finishConnect();
+        }
+        co_return std::move(strSock);
+    }
+
+    Task<StreamSocket> asyncAccept(EventLoop& loop, ServerSocket& servSock){
+        servSock.setNonBlockIO(true);
+        std::vector<StreamSocket> accepted;
+        while(servSock.acceptBatch(accepted, 1) == 0){
+            co_await readable(loop, servSock.getFd());
+        }
+        co_return std::move(accepted.front());
+    }
+
+    Task<> asyncSendBuff(EventLoop& loop, StreamSocket& strSock, const void* buffer, std::size_t bufferSize){
+        const char* bufferHead = reinterpret_cast<const char*>(buffer);
+        std::size_t bytesSent = 0;
+        while(bytesSent != bufferSize){
+            bytesSent += co_await asyncSend(loop, strSock, bufferHead + bytesSent, bufferSize - bytesSent);
+        }
+    }
+
+    Task<std::size_t> asyncSendFile(EventLoop& loop, StreamSocket& strSock, int fileFd, off_t offset, std::size_t length){
+        strSock.setNonBlockIO(true);
+        std::size_t totalSent = 0;
+        while(totalSent != length){
+            std::size_t bytesSent = 0;
+            if(!strSock.trySendFile(fileFd, offset, length - totalSent, bytesSent)){
+                co_await writable(loop, strSock.getFd());
+                continue;
+            }
+            if(bytesSent == 0){
+                break; //end of the file
+            }
+            totalSent += bytesSent;
+        }
+        co_return totalSent;
+    }
+
+    Task<std::size_t> asyncReceiveToFile(EventLoop& loop, StreamSocket& strSock, int fileFd, off_t offset, std::size_t length){
+        strSock.setNonBlockIO(true);
+        std::size_t totalReceived = 0;
+        try{
+            while(totalReceived != length){
+                std::size_t bytesReceived = 0;
+                if(!strSock.tryReceiveToFile(fileFd, offset, length - totalReceived, bytesReceived)){
+                    co_await readable(loop, strSock.getFd());
+                    continue;
+                }
+                totalReceived += bytesReceived;
+            }
+        }catch(SnlEofException&){
+            //short transfer, reported through the count
+        }
+        co_return totalReceived;
+    }
+
+    Task<> asyncSendline(EventLoop& loop, StreamSocket& strSock, std::string line, std::string eol){
+        line += eol;
+        co_await asyncSendBuff(loop, strSock, line.data(), line.size());
+    }
+
+    Task<std::size_t> asyncReadline(EventLoop& loop, StreamSocket& strSock, std::string& lineBuff, std::string eol){
+        strSock.setNonBlockIO(true);
+        lineBuff.clear();
+        //same chunked peek scan as the blocking readline: the available data is peeked (MSG_PEEK) and only
+        //the bytes up to the delimiter are consumed, so nothing past the line is read
+        std::size_t used = 0; //bytes of the line consumed from the socket
+        while(true){
+            //grow geometrically, a long line costs a logarithmic number of peeks
+            lineBuff.resize(std::max<std::size_t>(used * 2, used + 256));
+            std::size_t peeked = 0;
+            while(!strSock.tryReceive(lineBuff.data() + used, lineBuff.size() - used, peeked, MSG_PEEK)){
+                co_await readable(loop, strSock.getFd());
+            }
+
+            //the delimiter may start in the bytes consumed before
+            std::size_t from = used >= eol.size() ? used - (eol.size() - 1) : 0;
+            std::string_view searched(lineBuff.data(), used + peeked);
+            std::size_t position = eol.empty() ? used : searched.find(eol, from);
+            std::size_t consumed = position != std::string_view::npos ? position + eol.size() - used : peeked;
+            //the peeked bytes are in the socket buffer, the receive takes them without blocking
+            std::size_t bytesReceived = 0;
+            strSock.tryReceive(lineBuff.data() + used, consumed, bytesReceived, MSG_WAITALL);
+            if(position != std::string_view::npos){
+                lineBuff.resize(position);
+                co_return position;
+            }
+            used += peeked;
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef ASYNCSOCKET_H
+#define ASYNCSOCKET_H
+//c headers
+#include <sys/epoll.h>
+#include <sys/types.h>
+//cpp headers
+#include <coroutine>
+#include <cstdint>
+#include <string>
+//own headers
+#include "EventLoop.h"
+#include "StreamSocket.h"
+#include "Task.h"
+
+namespace snl{
+
+    //forward declarations
+    class ServerSocket;
+    class SocketAddress;
+
+    /**
+     * Awaitable that suspends the coroutine until the fd is ready, it is resumed from the event loop
+     * note: the loop must keep running (run/runOnce) for the coroutine to make progress
+     */
+    class FdReady
+    {
+    public:
+
+        FdReady(EventLoop& loop_, Fd fd_, std::uint32_t events_) noexcept : loop(loop_), fd(fd_), events(events_) { }
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> awaiting){
+            loop.watchFd(fd, events, [awaiting](EventLoop&, std::uint32_t){ awaiting.resume(); });
+        }
+
+        void await_resume() const noexcept { }
+
+    private:
+        EventLoop& loop;
+        Fd fd;
+        std::uint32_t events;
+    };
+
+    inline FdReady readable(EventLoop& loop, Fd fd){ return FdReady(loop, fd, EPOLLIN | EPOLLRDHUP); }
+    inline FdReady writable(EventLoop& loop, Fd fd){ return FdReady(loop, fd, EPOLLOUT); }
+
+    /**
+     * @brief starts a coroutine without awaiting it, the coroutine runs until its first suspension
+     *        and is destroyed once it completes
+     * @param task the task to run
+     * note: an SnlException escaping the task ends it silently (the connection is simply dropped),
+     *       any other exception terminates the program
+     */
+    void spawn(Task<> task);
+
+    /*
+     * the awaitable socket calls below mirror the blocking api, every call first tries the operation
+     * and only suspends (until the loop reports the socket ready) when it would block
+     * the sockets are set to non blocking and must stay alive until the returned task completes
+     */
+
+    /**
+     * @brief sends (part of) the buffer, suspends until at least one byte can be written
+     * @return the number of bytes sent
+     */
+    Task<std::size_t> asyncSend(EventLoop& loop, StreamSocket& strSock, const void* buffer, std::size_t bufferSize, int flags = 0);
+
+    /**
+     * @brief receives the data that is available, suspends until at least one byte is available
+     * @return the number of bytes received
+     * @throws SnlEofException when the end of the stream is reached
+     */
+    Task<std::size_t> asyncReceive(EventLoop& loop, StreamSocket& strSock, void* buffer, std::size_t bufferSize, int flags = 0);
+
+    /**
+     * @brief connects a new socket to the address, suspends while the connection is in progress
+     * @return the connected (non blocking) socket
+     */
+    Task<StreamSocket> asyncConnect(EventLoop& loop, const SocketAddress& sockAddr);
+
+    /**
+     * @brief accepts the next connection on the listening socket, suspends while the backlog is empty
+     * @return the accepted (non blocking) socket
+     * note: the server socket must not be registered with addServer on the same loop
+     */
+    Task<StreamSocket> asyncAccept(EventLoop& loop, ServerSocket& servSock);
+
+    /**
+     * @brief sends the complete buffer, suspends whenever the socket buffer is full
+     */
+    Task<> asyncSendBuff(EventLoop& loop, StreamSocket& strSock, const void* buffer, std::size_t bufferSize);
+
+    /**
+     * @brief sends length bytes of the file starting at offset (sendfile), suspends whenever the socket buffer is full
+     * @return the number of bytes sent, less than length only if the file ended first
+     */
+    Task<std::size_t> asyncSendFile(EventLoop& loop, StreamSocket& strSock, int fileFd, off_t offset, std::size_t length);
+
+    /**
+     * @brief receives length bytes into the file starting at offset (splice), suspends while no data is available
+     * @return the number of bytes received, less than length only if the stream ended first
+     */
+    Task<std::size_t> asyncReceiveToFile(EventLoop& loop, StreamSocket& strSock, int fileFd, off_t offset, std::size_t length);
+
+    /**
+     * @brief sends a line followed by the end of line delimiter
+     * note: the line is copied into the coroutine, the caller does not have to keep it alive
+     */
+    Task<> asyncSendline(EventLoop& loop, StreamSocket& strSock, std::string line, std::string eol = "\r\n");
+
+    /**
+     * @brief reads a single line (without the delimiter) into the line buffer
+     * @return the size of the line
+     */
+    Task<std::size_t> asyncReadline(EventLoop& loop, StreamSocket& strSock, std::string& lineBuff, std::string eol = "\r\n");
+}
+
+#endif // ASYNCSOCKET_H
@@ -0,0 +1,342 @@
+#include "BufferPool.h"
+//c headers
+#include <cerrno>
+#include <sys/mman.h>
+//cpp headers
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <utility>
+#include <vector>
+//own headers
+#include "SnlException.h"
+
+namespace snl{
+
+    /*
+     * leases
+     */
+
+    PooledBuffer::PooledBuffer(BufferPool* pool_, char* buffer_, std::size_t capacity_) noexcept :
+        pool(pool_), buffer(buffer_), bufferCapacity(capacity_) { }
+
+    PooledBuffer::PooledBuffer(PooledBuffer&& rhs) noexcept :
+        pool(std::exchange(rhs.pool, nullptr)), buffer(std::exchange(rhs.buffer, nullptr)),
+        bufferCapacity(std::exchange(rhs.bufferCapacity, 0)) { }
+
+    PooledBuffer& PooledBuffer::operator=(PooledBuffer&& rhs) noexcept{
+        if(this != &rhs){
+            release();
+            pool = std::exchange(rhs.pool, nullptr);
+            buffer = std::exchange(rhs.buffer, nullptr);
+            bufferCapacity = std::exchange(rhs.bufferCapacity, 0);
+        }
+        return *this;
+    }
+
+    PooledBuffer::~PooledBuffer(){
+        release();
+    }
+
+    void PooledBuffer::release() noexcept{
+        if(pool != nullptr){
+            pool->deallocate(buffer, bufferCapacity);
+        }
+        pool = nullptr;
+        buffer = nullptr;
+        bufferCapacity = 0;
+    }
+
+    /*
+     * shared tier
+     */
+
+    struct BufferPool::Shared{
+
+        explicit Shared(Config config_) : config(config_){
+            config.minBufferSize = std::bit_ceil(std::max<std::size_t>(config.minBufferSize, 64));
+            config.maxBufferSize = std::bit_ceil(std::max(config.maxBufferSize, config.minBufferSize));
+            config.slabSize = std::max(config.slabSize, config.maxBufferSize);
+            minShift = static_cast<std::size_t>(std::countr_zero(config.minBufferSize));
+            classCount = static_cast<std::size_t>(std::countr_zero(config.maxBufferSize)) - minShift + 1;
+            freeLists.resize(classCount);
+        }
+
+        ~Shared(){
+            for(auto& slab : slabs){
+                ::munmap(slab.first, slab.second);
+            }
+        }
+
+        std::size_t getBlockSize(std::size_t sizeClass) const noexcept{
+            return config.minBufferSize << sizeClass;
+        }
+
+        //number of buffers moved between a thread and the shared tier at once
+        std::size_t getBatchSize(std::size_t sizeClass) const noexcept{
+            return std::max<std::size_t>(config.threadCacheBytes / getBlockSize(sizeClass) / 2, 1);
+        }
+
+        //moves a batch of free buffers to the thread list, carving new ones if the shared list runs dry
+        void refill(std::size_t sizeClass, std::vector<char*>& threadList){
+            std::size_t batchSize = getBatchSize(sizeClass);
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<char*>& sharedList = freeLists[sizeClass];
+            std::size_t taken = std::min(batchSize, sharedList.size());
+            threadList.insert(threadList.end(), sharedList.end() - taken, sharedList.end());
+            sharedList.resize(sharedList.size() - taken);
+            for(; taken < batchSize; taken++){
+                threadList.push_back(carve(getBlockSize(sizeClass)));
+            }
+            stats.refills++;
+        }
+
+        //single buffer version of refill for a thread without a cache
+        char* take(std::size_t sizeClass){
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<char*>& sharedList = freeLists[sizeClass];
+            if(sharedList.empty()){
+                return carve(getBlockSize(sizeClass));
+            }
+            char* buffer = sharedList.back();
+            sharedList.pop_back();
+            return buffer;
+        }
+
+        //single buffer version of drain for a thread without a cache
+        void give(std::size_t sizeClass, char* buffer){
+            std::lock_guard<std::mutex> lock(mutex);
+            freeLists[sizeClass].push_back(buffer);
+        }
+
+        //moves count buffers from the end of the thread list back to the shared tier
+        void drain(std::size_t sizeClass, std::vector<char*>& threadList, std::size_t count){
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<char*>& sharedList = freeLists[sizeClass];
+            sharedList.insert(sharedList.end(), threadList.end() - count, threadList.end());
+            threadList.resize(threadList.size() - count);
+            stats.drains++;
+        }
+
+        //cuts a block from the current slab, maps a new slab when it is used up (must be locked)
+        char* carve(std::size_t blockSize){
+            if(slabRemaining < blockSize){
+                //the rest of the slab is smaller than any block that is still to come of this size, it stays unused
+                bool huge = false;
+                slabCursor = static_cast<char*>(mapMemory(config.slabSize, config.hugePages, huge));
+                slabRemaining = config.slabSize;
+                slabs.emplace_back(slabCursor, config.slabSize);
+                stats.slabs++;
+                stats.hugeSlabs += huge ? 1 : 0;
+            }
+            char* block = slabCursor;
+            slabCursor += blockSize;
+            slabRemaining -= blockSize;
+            return block;
+        }
+
+        static void* mapMemory(std::size_t size, HugePages hugePages, bool& huge){
+            void* memory = MAP_FAILED;
+            if(hugePages == HugePages::EXPLICIT){
+                memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                huge = memory != MAP_FAILED;
+            }
+            if(memory == MAP_FAILED){
+                //no huge pages reserved (or not requested), use normal pages
+                memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if(memory == MAP_FAILED){
+                    throw SnlException("BufferPool error: ", errno);
+                }
+                if(hugePages != HugePages::NONE){
+                    ::madvise(memory, size, MADV_HUGEPAGE); //only advice, the kernel may ignore it
+                }
+            }
+            return memory;
+        }
+
+        Config config;
+        std::size_t minShift = 0;
+        std::size_t classCount = 0;
+        std::atomic<bool> closed{false}; //the pool is gone, the thread caches drop their entry
+
+        mutable std::mutex mutex;
+        std::vector<std::vector<char*>> freeLists;
+        std::vector<std::pair<void*, std::size_t>> slabs;
+        char* slabCursor = nullptr;
+        std::size_t slabRemaining = 0;
+        Stats stats;
+    };
+
+    /*
+     * thread tier
+     */
+
+    struct BufferPool::ThreadCache{
+
+        explicit ThreadCache(std::shared_ptr<Shared> shared_) : shared(std::move(shared_)), freeLists(shared->classCount) { }
+
+        ~ThreadCache(){
+            //hand the buffers back, other threads can still use them
+            for(std::size_t sizeClass = 0; sizeClass != freeLists.size(); sizeClass++){
+                if(!freeLists[sizeClass].empty()){
+                    shared->drain(sizeClass, freeLists[sizeClass], freeLists[sizeClass].size());
+                }
+            }
+        }
+
+        std::shared_ptr<Shared> shared;
+        std::vector<std::vector<char*>> freeLists;
+    };
+
+    /*
+     * pool
+     */
+
+    static std::atomic<std::uint64_t> nextPoolId{0};
+
+    BufferPool::BufferPool() : BufferPool(Config()) { }
+
+    BufferPool::BufferPool(Config config) : shared(std::make_shared<Shared>(config)), poolId(nextPoolId++) { }
+
+    BufferPool::~BufferPool(){
+        //the thread caches drop their entry on their next use of any pool or when their thread ends,
+        //the last one releases the slabs
+        shared->closed = true;
+    }
+
+    PooledBuffer BufferPool::acquire(std::size_t size){
+        std::size_t capacity = 0;
+        char* buffer = allocate(size, capacity);
+        return PooledBuffer(this, buffer, capacity);
+    }
+
+    char* BufferPool::allocate(std::size_t size, std::size_t& capacity){
+        const Config& config = shared->config;
+        if(size > config.maxBufferSize){
+            bool huge = false;
+            capacity = (size + config.minBufferSize - 1) / config.minBufferSize * config.minBufferSize;
+            char* buffer = static_cast<char*>(Shared::mapMemory(capacity, HugePages::NONE, huge));
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->stats.oversized++;
+            return buffer;
+        }
+
+        capacity = std::bit_ceil(std::max(size, config.minBufferSize));
+        std::size_t sizeClass = static_cast<std::size_t>(std::countr_zero(capacity)) - shared->minShift;
+        ThreadCache* threadCache = getThreadCache();
+        if(threadCache == nullptr){
+            return shared->take(sizeClass);
+        }
+        std::vector<char*>& freeList = threadCache->freeLists[sizeClass];
+        if(freeList.empty()){
+            shared->refill(sizeClass, freeList);
+        }
+        char* buffer = freeList.back();
+        freeList.pop_back();
+        return buffer;
+    }
+
+    void BufferPool::deallocate(char* buffer, std::size_t capacity) noexcept{
+        if(buffer == nullptr){
+            return;
+        }
+        if(capacity > shared->config.maxBufferSize){
+            ::munmap(buffer, capacity);
+            return;
+        }
+
+        std::size_t sizeClass = static_cast<std::size_t>(std::countr_zero(capacity)) - shared->minShift;
+        ThreadCache* threadCache = getThreadCache();
+        if(threadCache == nullptr){
+            shared->give(sizeClass, buffer);
+            return;
+        }
+        std::vector<char*>& freeList = threadCache->freeLists[sizeClass];
+        freeList.push_back(buffer);
+        //a thread that releases more than it allocates (e.g. a writer thread) passes the surplus on
+        std::size_t batchSize = shared->getBatchSize(sizeClass);
+        if(freeList.size() >= 2 * batchSize){
+            shared->drain(sizeClass, freeList, batchSize);
+        }
+    }
+
+    std::size_t BufferPool::getCapacity(std::size_t size) const noexcept{
+        const Config& config = shared->config;
+        if(size > config.maxBufferSize){
+            return (size + config.minBufferSize - 1) / config.minBufferSize * config.minBufferSize;
+        }
+        return std::bit_ceil(std::max(size, config.minBufferSize));
+    }
+
+    void BufferPool::reserve(std::size_t size, std::size_t count){
+        std::size_t capacity = getCapacity(size);
+        if(capacity > shared->config.maxBufferSize){
+            return;
+        }
+        std::size_t sizeClass = static_cast<std::size_t>(std::countr_zero(capacity)) - shared->minShift;
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        std::vector<char*>& sharedList = shared->freeLists[sizeClass];
+        sharedList.reserve(sharedList.size() + count);
+        for(std::size_t index = 0; index != count; index++){
+            sharedList.push_back(shared->carve(capacity));
+        }
+    }
+
+    BufferPool::Stats BufferPool::getStats() const{
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        return shared->stats;
+    }
+
+    BufferPool& BufferPool::getDefault(){
+        static BufferPool defaultPool;
+        return defaultPool;
+    }
+
+    BufferPool& BufferPool::getStatePool(){
+        Config config;
+        config.minBufferSize = 64;
+        config.maxBufferSize = 1024;
+        config.slabSize = 256 * 1024;
+        config.threadCacheBytes = 32 * 1024;
+        static BufferPool* statePool = new BufferPool(config); //leaked on purpose, see the header
+        return *statePool;
+    }
+
+    //set when the caches of the thread are destroyed, a plain bool is never destroyed itself
+    static thread_local bool threadCachesGone = false;
+
+    //the caches of a thread, a short list beats a map as a thread only uses a handful of pools
+    struct BufferPool::ThreadCacheList{
+        ~ThreadCacheList(){
+            threadCachesGone = true; //the buffers released while (or after) the caches drain go to the shared tier
+        }
+
+        std::vector<std::pair<std::uint64_t, std::unique_ptr<ThreadCache>>> caches;
+    };
+
+    BufferPool::ThreadCache* BufferPool::getThreadCache(){
+        if(threadCachesGone){
+            return nullptr;
+        }
+        thread_local ThreadCacheList threadCacheList;
+        auto& threadCaches = threadCacheList.caches;
+
+        ThreadCache* found = nullptr;
+        for(auto cacheIt = threadCaches.begin(); cacheIt != threadCaches.end();){
+            if(cacheIt->second->shared->closed){
+                cacheIt = threadCaches.erase(cacheIt); //the pool is gone, give its memory back
+                continue;
+            }
+            if(cacheIt->first == poolId){
+                found = cacheIt->second.get();
+            }
+            ++cacheIt;
+        }
+        if(found == nullptr && !shared->closed){
+            threadCaches.emplace_back(poolId, std::make_unique<ThreadCache>(shared));
+            found = threadCaches.back().second.get();
+        }
+        return found;
+    }
+}
@@ -0,0 +1,146 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+//c headers
+//cpp headers
+#include <cstdint>
+#include <memory>
+#include <span>
+//own headers
+
+namespace snl{
+
+    class PooledBuffer;
+
+    /**
+     * Pool of i/o buffers in power of two size classes
+     * the buffers are carved out of large slabs (optionally backed by huge pages to save tlb misses).
+     * Every thread keeps a small free list per size class, so most allocations take no lock: the lists are
+     * refilled from and drained to a shared tier in batches, which rebalances the buffers between threads.
+     * Requests above the largest size class are mapped directly and unmapped on release.
+     * note: the buffers must be released before the pool is destroyed
+     */
+    class BufferPool
+    {
+    public:
+
+        enum class HugePages:std::uint8_t {NONE = 0, TRANSPARENT = 1, EXPLICIT = 2};
+
+        struct Config{
+            std::size_t minBufferSize = 256; //smallest size class (rounded up to a power of two)
+            std::size_t maxBufferSize = 1024 * 1024; //largest size class (rounded up to a power of two)
+            std::size_t slabSize = 2 * 1024 * 1024; //memory mapped at once for the size classes
+            std::size_t threadCacheBytes = 512 * 1024; //bytes a thread keeps per size class before returning a batch
+            //TRANSPARENT advises the kernel to back the slabs with huge pages (MADV_HUGEPAGE),
+            //EXPLICIT maps them from the reserved huge pages (MAP_HUGETLB) and falls back to normal pages if none are left
+            HugePages hugePages = HugePages::NONE;
+        };
+
+        struct Stats{
+            std::size_t slabs = 0; //slabs mapped
+            std::size_t hugeSlabs = 0; //slabs backed by explicit huge pages
+            std::size_t refills = 0; //batches moved from the shared tier to a thread
+            std::size_t drains = 0; //batches moved from a thread to the shared tier
+            std::size_t oversized = 0; //buffers above the largest size class
+        };
+
+        BufferPool();
+        explicit BufferPool(Config config);
+        ~BufferPool();
+
+        BufferPool(const BufferPool& rhs) = delete;
+        BufferPool& operator=(const BufferPool& rhs) = delete;
+
+        /**
+         * @brief takes a buffer of at least size bytes from the pool
+         * @throws SnlException if no memory could be mapped
+         */
+        PooledBuffer acquire(std::size_t size);
+
+        /**
+         * @brief raw interface of acquire, capacity is set to the usable size of the buffer
+         */
+        char* allocate(std::size_t size, std::size_t& capacity);
+
+        /**
+         * @brief returns a buffer obtained from allocate (capacity as returned by allocate)
+         */
+        void deallocate(char* buffer, std::size_t capacity) noexcept;
+
+        /**
+         * @brief the capacity allocate hands out for a request of size bytes
+         */
+        std::size_t getCapacity(std::size_t size) const noexcept;
+
+        /**
+         * @brief carves count buffers of at least size bytes up front into the shared tier (one lock for all)
+         * note: oversized requests are not reserved, they are always mapped on demand
+         */
+        void reserve(std::size_t size, std::size_t count);
+
+        Stats getStats() const;
+
+        /**
+         * @brief the pool used by the buffered readers and writers of the library
+         */
+        static BufferPool& getDefault();
+
+        /**
+         * @brief the pool the socket state machines are allocated from (small size classes only)
+         * note: never destroyed, sockets may still be released during the static destruction
+         *       (a thread whose caches are gone allocates and releases through the shared tier)
+         */
+        static BufferPool& getStatePool();
+
+    private:
+
+        struct Shared;
+        struct ThreadCache;
+        struct ThreadCacheList;
+
+        //the cache of the calling thread for this pool, created on first use
+        //nullptr once the caches of the thread are destroyed (thread exit, static destruction) or the pool is closed
+        ThreadCache* getThreadCache();
+
+        std::shared_ptr<Shared> shared; //also owned by the thread caches, which may outlive the pool
+        std::uint64_t poolId;
+    };
+
+    /**
+     * A buffer leased from a BufferPool, returned to the pool when the lease is destroyed
+     */
+    class PooledBuffer
+    {
+    public:
+
+        friend class BufferPool;
+
+        PooledBuffer() = default;
+        PooledBuffer(PooledBuffer&& rhs) noexcept;
+        PooledBuffer& operator=(PooledBuffer&& rhs) noexcept;
+        ~PooledBuffer();
+
+        PooledBuffer(const PooledBuffer& rhs) = delete;
+        PooledBuffer& operator=(const PooledBuffer& rhs) = delete;
+
+        char* data() noexcept { return buffer; }
+        const char* data() const noexcept { return buffer; }
+        std::size_t capacity() const noexcept { return bufferCapacity; }
+        std::span<char> span() noexcept { return std::span<char>(buffer, bufferCapacity); }
+        bool empty() const noexcept { return buffer == nullptr; }
+
+        /**
+         * @brief returns the buffer to the pool now (the lease becomes empty)
+         */
+        void release() noexcept;
+
+    private:
+
+        PooledBuffer(BufferPool* pool_, char* buffer_, std::size_t capacity_) noexcept;
+
+        BufferPool* pool = nullptr;
+        char* buffer = nullptr;
+        std::size_t bufferCapacity = 0;
+    };
+}
+
+#endif // BUFFERPOOL_H
@@ -0,0 +1,147 @@
+#include "BufferedStreamReader.h"
+//c headers
+#include <cerrno>
+#include <poll.h>
+//cpp headers
+#include <algorithm>
+#include <cstring>
+//own headers
+#include "SnlException.h"
+
+namespace snl{
+
+    BufferedStreamReader::BufferedStreamReader(StreamSocket& strSock_, std::size_t capacity, std::size_t maxSize_) :
+        strSock(strSock_), buffer(BufferPool::getDefault().acquire(capacity)), maxSize(std::max(maxSize_, buffer.capacity())) { }
+
+    std::string_view BufferedStreamReader::readline(std::string_view eol){
+        std::string_view line = readUntil(eol);
+        line.remove_suffix(eol.size());
+        return line;
+    }
+
+    std::string_view BufferedStreamReader::readUntil(std::string_view delim){
+        if(delim.empty()){
+            throw SnlException("BufferedStreamReader error: the delimiter can not be empty");
+        }
+
+        while(true){
+            //resume the search where the previous one stopped, a delimiter may straddle the boundary
+            std::size_t from = scanned >= delim.size() ? scanned - (delim.size() - 1) : 0;
+            std::string_view unread(buffer.data() + head, tail - head);
+            std::size_t position = unread.find(delim, from);
+            if(position != std::string_view::npos){
+                std::size_t recordSize = position + delim.size();
+                std::string_view record = unread.substr(0, recordSize);
+                consume(recordSize);
+                return record;
+            }
+
+            scanned = unread.size();
+            if(unread.size() >= maxSize){
+                throw SnlException("BufferedStreamReader error: no delimiter within the maximum size: ", EMSGSIZE);
+            }
+            fill();
+        }
+    }
+
+    std::string_view BufferedStreamReader::readExact(std::size_t byteCount){
+        std::string_view data = peek(byteCount).substr(0, byteCount);
+        consume(byteCount);
+        return data;
+    }
+
+    std::string_view BufferedStreamReader::peek(){
+        if(head == tail){
+            fill();
+        }
+        return std::string_view(buffer.data() + head, tail - head);
+    }
+
+    std::string_view BufferedStreamReader::peek(std::size_t byteCount){
+        if(byteCount > maxSize){
+            throw SnlException("BufferedStreamReader error: the request exceeds the maximum size: ", EMSGSIZE);
+        }
+        while(tail - head < byteCount){
+            reserve(byteCount - (tail - head));
+            fill();
+        }
+        return std::string_view(buffer.data() + head, tail - head);
+    }
+
+    std::size_t BufferedStreamReader::read(void* buffer_, std::size_t bufferSize){
+        if(bufferSize == 0){
+            return 0;
+        }
+        std::string_view data = peek();
+        std::size_t bytesCopied = std::min(bufferSize, data.size());
+        std::memcpy(buffer_, data.data(), bytesCopied);
+        consume(bytesCopied);
+        return bytesCopied;
+    }
+
+    void BufferedStreamReader::consume(std::size_t byteCount){
+        byteCount = std::min(byteCount, tail - head);
+        head += byteCount;
+        scanned = 0;
+        if(head == tail){
+            head = tail = 0; //cheap reset, the next receive gets the whole buffer
+        }
+    }
+
+    std::size_t BufferedStreamReader::getBufferedSize() const noexcept{
+        return tail - head;
+    }
+
+    StreamSocket& BufferedStreamReader::getSocket() noexcept{
+        return strSock;
+    }
+
+    void BufferedStreamReader::fill(){
+        if(tail == buffer.capacity()){
+            reserve(1);
+        }
+
+        std::size_t bytesReceived = 0;
+        if(!strSock.isNonBlock()){
+            bytesReceived = strSock.receive(buffer.data() + tail, buffer.capacity() - tail);
+        }else{
+            while(!strSock.tryReceive(buffer.data() + tail, buffer.capacity() - tail, bytesReceived)){
+                waitReadable();
+            }
+        }
+        tail += bytesReceived;
+    }
+
+    void BufferedStreamReader::reserve(std::size_t byteCount){
+        std::size_t unread = tail - head;
+        if(buffer.capacity() - tail >= byteCount){
+            return;
+        }
+
+        //move the unread bytes to the front first, only grow if that is not enough
+        if(head != 0){
+            std::memmove(buffer.data(), buffer.data() + head, unread);
+            head = 0;
+            tail = unread;
+        }
+        if(buffer.capacity() - tail < byteCount){
+            if(unread + byteCount > maxSize){
+                throw SnlException("BufferedStreamReader error: the buffer would exceed the maximum size: ", EMSGSIZE);
+            }
+            PooledBuffer grown = BufferPool::getDefault().acquire(std::min(std::max(buffer.capacity() * 2, unread + byteCount), maxSize));
+            std::memcpy(grown.data(), buffer.data(), unread);
+            buffer = std::move(grown);
+        }
+    }
+
+    void BufferedStreamReader::waitReadable(){
+        pollfd pollFd{};
+        pollFd.fd = strSock.getFd();
+        pollFd.events = POLLIN;
+        while(::poll(&pollFd, 1, -1) == -1){
+            if(errno != EINTR){
+                throw SnlException("BufferedStreamReader error: ", errno);
+            }
+        }
+    }
+}
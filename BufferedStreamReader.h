@@ -0,0 +1,101 @@
+#ifndef BUFFEREDSTREAMREADER_H
+#define BUFFEREDSTREAMREADER_H
+//c headers
+//cpp headers
+#include <string_view>
+//own headers
+#include "BufferPool.h"
+#include "StreamSocket.h"
+
+namespace snl{
+
+    /**
+     * Buffered reader on top of a connected stream socket
+     * the socket is read in large chunks into an internal buffer, the delimiters are searched in the buffer
+     * (every byte is scanned once) and the bytes past the requested data are kept for the next call.
+     * The returned views point into the internal buffer: they are only valid until the next call on the reader.
+     * note: the reader owns the receive side of the socket, mixing it with direct receives loses the buffered bytes
+     * note: all the calls block until the data is there (independent of the socket non blocking behavior)
+     * note: the buffer is taken from the default BufferPool and returned to it with the reader
+     */
+    class BufferedStreamReader
+    {
+    public:
+
+        static constexpr std::size_t defaultCapacity = 16 * 1024;
+        static constexpr std::size_t defaultMaxSize = 1024 * 1024;
+
+        /**
+         * @param strSock the socket to read from, must outlive the reader
+         * @param capacity the initial size of the buffer (the size of a single receive)
+         * @param maxSize the limit the buffer may grow to for a single line, delimited record or readExact
+         */
+        explicit BufferedStreamReader(StreamSocket& strSock, std::size_t capacity = defaultCapacity, std::size_t maxSize = defaultMaxSize);
+
+        BufferedStreamReader(const BufferedStreamReader& rhs) = delete;
+        BufferedStreamReader& operator=(const BufferedStreamReader& rhs) = delete;
+
+        /**
+         * @brief reads a single line
+         * @return the line without the end of line delimiter
+         * @throws SnlException if the line does not fit in the maximum size, SnlEofException if the stream ends first
+         */
+        std::string_view readline(std::string_view eol = "\r\n");
+
+        /**
+         * @brief reads up to and including the delimiter
+         * @throws SnlException if the record does not fit in the maximum size, SnlEofException if the stream ends first
+         */
+        std::string_view readUntil(std::string_view delim);
+
+        /**
+         * @brief reads exactly byteCount bytes
+         * @throws SnlException if byteCount exceeds the maximum size, SnlEofException if the stream ends first
+         */
+        std::string_view readExact(std::size_t byteCount);
+
+        /**
+         * @brief returns the buffered bytes without consuming them, receives once if nothing is buffered
+         * @throws SnlEofException if nothing is buffered and the stream ended
+         */
+        std::string_view peek();
+
+        /**
+         * @brief returns at least byteCount bytes without consuming them (all the buffered bytes)
+         * @throws SnlException if byteCount exceeds the maximum size, SnlEofException if the stream ends first
+         */
+        std::string_view peek(std::size_t byteCount);
+
+        /**
+         * @brief consumes up to bufferSize bytes (buffered bytes first, else a single receive) into the buffer
+         * @return the number of bytes copied
+         */
+        std::size_t read(void* buffer, std::size_t bufferSize);
+
+        /**
+         * @brief drops byteCount buffered bytes (e.g. after a peek)
+         */
+        void consume(std::size_t byteCount);
+
+        std::size_t getBufferedSize() const noexcept;
+        StreamSocket& getSocket() noexcept;
+
+    private:
+
+        //receives once into the free space of the buffer, making room first
+        void fill();
+        //makes room for at least byteCount bytes past the unread data (compacts, then grows)
+        void reserve(std::size_t byteCount);
+        //blocks until the socket is readable (non blocking sockets only)
+        void waitReadable();
+
+        StreamSocket& strSock;
+        PooledBuffer buffer;
+        std::size_t maxSize;
+        std::size_t head = 0; //first unread byte
+        std::size_t tail = 0; //end of the received bytes
+        std::size_t scanned = 0; //bytes after head already searched for the delimiter
+    };
+}
+
+#endif // BUFFEREDSTREAMREADER_H
@@ -0,0 +1,208 @@
+#include "ConnectionPool.h"
+//c headers
+#include <cerrno>
+#include <sys/socket.h>
+//cpp headers
+#include <algorithm>
+#include <optional>
+#include <utility>
+//own headers
+#include "SnlException.h"
+
+namespace snl{
+
+    /*
+     * leases
+     */
+
+    PooledConnection::PooledConnection(ConnectionPool* pool_, ConnectionPool::Endpoint* endpoint_, StreamSocket&& strSock_) noexcept :
+        pool(pool_), endpoint(endpoint_), strSock(std::move(strSock_)) { }
+
+    PooledConnection::PooledConnection(PooledConnection&& rhs) noexcept :
+        pool(std::exchange(rhs.pool, nullptr)), endpoint(std::exchange(rhs.endpoint, nullptr)),
+        strSock(std::move(rhs.strSock)), reusable(rhs.reusable) { }
+
+    PooledConnection& PooledConnection::operator=(PooledConnection&& rhs) noexcept{
+        if(this != &rhs){
+            release();
+            pool = std::exchange(rhs.pool, nullptr);
+            endpoint = std::exchange(rhs.endpoint, nullptr);
+            strSock = std::move(rhs.strSock);
+            reusable = rhs.reusable;
+        }
+        return *this;
+    }
+
+    PooledConnection::~PooledConnection(){
+        release();
+    }
+
+    void PooledConnection::release(){
+        if(pool == nullptr){
+            return;
+        }
+        ConnectionPool* owner = std::exchange(pool, nullptr);
+        owner->release(*endpoint, std::move(strSock), reusable);
+        endpoint = nullptr;
+    }
+
+    /*
+     * pool
+     */
+
+    ConnectionPool::ConnectionPool() : ConnectionPool(Config()) { }
+
+    ConnectionPool::ConnectionPool(Config config_) : config(config_){
+        if(config.maxTotal == 0){
+            throw SnlException("ConnectionPool error: the maximum number of connections must be at least one");
+        }
+    }
+
+    ConnectionPool::~ConnectionPool() = default; //the idle connections are closed by their sockets
+
+    PooledConnection ConnectionPool::acquire(const SocketAddress& sockAddr){
+        std::deque<StreamSocket> closing; //closed outside of the lock
+        std::unique_lock<std::mutex> lock(poolMutex);
+        Endpoint& endpoint = getEndpoint(sockAddr);
+        Clock::time_point deadline = Clock::now() + config.acquireTimeout;
+
+        while(true){
+            expire(endpoint, Clock::now(), closing);
+
+            //most recently used first, the connection least likely to be closed by the peer
+            while(!endpoint.idle.empty()){
+                StreamSocket strSock = std::move(endpoint.idle.back().strSock);
+                endpoint.idle.pop_back();
+                if(isAlive(strSock)){
+                    endpoint.leased++;
+                    stats.reused++;
+                    return PooledConnection(this, &endpoint, std::move(strSock));
+                }
+                stats.dead++;
+                closing.push_back(std::move(strSock));
+            }
+
+            if(endpoint.leased < config.maxTotal){
+                //reserve the slot, then connect without holding the lock
+                endpoint.leased++;
+                lock.unlock();
+                closing.clear();
+                StreamSocket strSock;
+                try{
+                    strSock.connect(endpoint.sockAddr, config.connectTimeout);
+                }catch(...){
+                    lock.lock();
+                    endpoint.leased--;
+                    endpoint.available.notify_one();
+                    throw;
+                }
+                lock.lock();
+                stats.connected++;
+                return PooledConnection(this, &endpoint, std::move(strSock));
+            }
+
+            if(endpoint.available.wait_until(lock, deadline) == std::cv_status::timeout && endpoint.idle.empty() && endpoint.leased >= config.maxTotal){
+                throw SnlException("ConnectionPool error: no connection available: ", ETIMEDOUT);
+            }
+        }
+    }
+
+    std::size_t ConnectionPool::prewarm(const SocketAddress& sockAddr, std::size_t count){
+        std::unique_lock<std::mutex> lock(poolMutex);
+        Endpoint& endpoint = getEndpoint(sockAddr);
+        std::size_t target = std::min(count, config.maxIdle);
+
+        while(endpoint.idle.size() < target && endpoint.idle.size() + endpoint.leased < config.maxTotal){
+            //the slot is reserved as a lease while connecting
+            endpoint.leased++;
+            lock.unlock();
+            StreamSocket strSock;
+            try{
+                strSock.connect(endpoint.sockAddr, config.connectTimeout);
+            }catch(...){
+                lock.lock();
+                endpoint.leased--;
+                endpoint.available.notify_one();
+                throw;
+            }
+            lock.lock();
+            endpoint.leased--;
+            stats.connected++;
+            endpoint.idle.push_back(IdleConnection{std::move(strSock), Clock::now()});
+            endpoint.available.notify_one();
+        }
+        return endpoint.idle.size();
+    }
+
+    std::size_t ConnectionPool::evictIdle(){
+        std::deque<StreamSocket> closing;
+        std::lock_guard<std::mutex> lock(poolMutex);
+        Clock::time_point now = Clock::now();
+        for(auto& entry : endpoints){
+            expire(*entry.second, now, closing);
+        }
+        return closing.size();
+    }
+
+    std::size_t ConnectionPool::getIdleCount(const SocketAddress& sockAddr){
+        std::lock_guard<std::mutex> lock(poolMutex);
+        return getEndpoint(sockAddr).idle.size();
+    }
+
+    std::size_t ConnectionPool::getLeasedCount(const SocketAddress& sockAddr){
+        std::lock_guard<std::mutex> lock(poolMutex);
+        return getEndpoint(sockAddr).leased;
+    }
+
+    ConnectionPool::Stats ConnectionPool::getStats(){
+        std::lock_guard<std::mutex> lock(poolMutex);
+        return stats;
+    }
+
+    ConnectionPool::Endpoint& ConnectionPool::getEndpoint(const SocketAddress& sockAddr){
+        auto endpointIt = endpoints.find(sockAddr);
+        if(endpointIt == endpoints.end()){
+            endpointIt = endpoints.emplace(sockAddr, std::make_unique<Endpoint>(sockAddr)).first;
+        }
+        return *endpointIt->second;
+    }
+
+    void ConnectionPool::expire(Endpoint& endpoint, Clock::time_point now, std::deque<StreamSocket>& closing){
+        while(!endpoint.idle.empty() && now - endpoint.idle.front().idleSince >= config.idleTimeout){
+            closing.push_back(std::move(endpoint.idle.front().strSock));
+            endpoint.idle.pop_front();
+            stats.evicted++;
+        }
+    }
+
+    void ConnectionPool::release(Endpoint& endpoint, StreamSocket&& strSock, bool reusable){
+        std::optional<StreamSocket> closing; //destroyed after the lock is released
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            endpoint.leased--;
+            //only a fully open connection can be handed out again
+            bool open = strSock.isConnected() && !strSock.upstreamClosed() && !strSock.downStreamClosed();
+            if(reusable && open && endpoint.idle.size() < config.maxIdle){
+                endpoint.idle.push_back(IdleConnection{std::move(strSock), Clock::now()});
+            }else{
+                if(reusable && open){
+                    stats.evicted++;
+                }
+                closing.emplace(std::move(strSock));
+            }
+        }
+        endpoint.available.notify_one();
+    }
+
+    bool ConnectionPool::isAlive(StreamSocket& strSock){
+        //an idle connection must have nothing to read: eof means the peer closed it,
+        //data means a stale response that would desynchronize the next request
+        char peekByte;
+        std::size_t bytesReceived = 0;
+        try{
+            return !strSock.tryReceive(&peekByte, sizeof(peekByte), bytesReceived, MSG_PEEK | MSG_DONTWAIT);
+        }catch(SnlException&){
+            return false; //eof or a reset
+        }
+    }
+}
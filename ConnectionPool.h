@@ -0,0 +1,160 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+//c headers
+//cpp headers
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+//own headers
+#include "SocketAddress.h"
+#include "StreamSocket.h"
+
+namespace snl{
+
+    class PooledConnection;
+
+    /**
+     * Thread safe pool of connected stream sockets per socket address
+     * idle connections are reused most recently used first, so surplus connections age out and are evicted.
+     * A connection is checked on checkout: if the peer closed it (or sent unexpected data) it is dropped.
+     */
+    class ConnectionPool
+    {
+    public:
+
+        friend class PooledConnection;
+
+        struct Config{
+            std::size_t maxIdle = 8; //idle connections kept per address
+            std::size_t maxTotal = 64; //idle plus leased connections per address, acquire waits when reached
+            std::chrono::milliseconds idleTimeout{30000}; //idle connections older than this are closed
+            std::chrono::milliseconds connectTimeout{5000};
+            std::chrono::milliseconds acquireTimeout{5000}; //maximum wait for a connection when maxTotal is reached
+        };
+
+        struct Stats{
+            std::size_t reused = 0; //checkouts served by an idle connection
+            std::size_t connected = 0; //new connections made
+            std::size_t dead = 0; //idle connections found closed on checkout
+            std::size_t evicted = 0; //idle connections closed because of the idle timeout or the idle limit
+        };
+
+        ConnectionPool();
+        explicit ConnectionPool(Config config);
+        ~ConnectionPool();
+
+        ConnectionPool(const ConnectionPool& rhs) = delete;
+        ConnectionPool& operator=(const ConnectionPool& rhs) = delete;
+
+        /**
+         * @brief leases a connection to the address, reusing an idle one if it is still alive
+         * @throws SnlException if no connection could be made, or with ETIMEDOUT if maxTotal
+         *         connections stayed leased for the acquire timeout
+         * note: the leases must not outlive the pool
+         */
+        PooledConnection acquire(const SocketAddress& sockAddr);
+
+        /**
+         * @brief opens connections to the address up to count idle connections (bounded by maxIdle)
+         * @return the number of idle connections for the address afterwards
+         */
+        std::size_t prewarm(const SocketAddress& sockAddr, std::size_t count);
+
+        /**
+         * @brief closes every idle connection that exceeded the idle timeout (for all addresses)
+         * @return the number of connections closed
+         * note: expired connections are also dropped by acquire, this call is for periodic cleanup
+         *       (e.g. from EventLoop::runAfter)
+         */
+        std::size_t evictIdle();
+
+        std::size_t getIdleCount(const SocketAddress& sockAddr);
+        std::size_t getLeasedCount(const SocketAddress& sockAddr);
+        Stats getStats();
+
+    private:
+
+        using Clock = std::chrono::steady_clock;
+
+        struct IdleConnection{
+            StreamSocket strSock;
+            Clock::time_point idleSince;
+        };
+
+        struct Endpoint{
+            explicit Endpoint(SocketAddress sockAddr_) : sockAddr(std::move(sockAddr_)) { }
+            SocketAddress sockAddr;
+            std::deque<IdleConnection> idle; //oldest at the front
+            std::size_t leased = 0;
+            std::condition_variable available; //signalled when a connection is released
+        };
+
+        //returns the entry of the address, created on first use (pool must be locked)
+        Endpoint& getEndpoint(const SocketAddress& sockAddr);
+        //moves the expired idle connections of the endpoint to the closing list (pool must be locked)
+        void expire(Endpoint& endpoint, Clock::time_point now, std::deque<StreamSocket>& closing);
+        //called by the leases
+        void release(Endpoint& endpoint, StreamSocket&& strSock, bool reusable);
+
+        //checks that the peer did not close the idle connection, never blocks
+        static bool isAlive(StreamSocket& strSock);
+
+        Config config;
+        std::mutex poolMutex;
+        std::unordered_map<SocketAddress, std::unique_ptr<Endpoint>> endpoints;
+        Stats stats;
+    };
+
+    /**
+     * A connection leased from a ConnectionPool, the connection returns to the pool when the lease is destroyed
+     * note: call discard() if the connection is in an unknown protocol state (e.g. a partially read response),
+     *       it is then closed instead of reused
+     */
+    class PooledConnection
+    {
+    public:
+
+        friend class ConnectionPool;
+
+        PooledConnection() = default;
+        PooledConnection(PooledConnection&& rhs) noexcept;
+        PooledConnection& operator=(PooledConnection&& rhs) noexcept;
+        ~PooledConnection();
+
+        PooledConnection(const PooledConnection& rhs) = delete;
+        PooledConnection& operator=(const PooledConnection& rhs) = delete;
+
+        StreamSocket& getSocket() noexcept { return strSock; }
+        StreamSocket* operator->() noexcept { return &strSock; }
+        StreamSocket& operator*() noexcept { return strSock; }
+
+        /**
+         * @brief marks the connection as not reusable, it is closed when the lease ends
+         */
+        void discard() noexcept { reusable = false; }
+
+        /**
+         * @brief returns the connection to the pool now (the lease becomes empty)
+         */
+        void release();
+
+        /**
+         * @brief checks if the lease holds a connection
+         */
+        explicit operator bool() const noexcept { return pool != nullptr; }
+
+    private:
+
+        PooledConnection(ConnectionPool* pool_, ConnectionPool::Endpoint* endpoint_, StreamSocket&& strSock_) noexcept;
+
+        ConnectionPool* pool = nullptr;
+        ConnectionPool::Endpoint* endpoint = nullptr; //the pool entry of the address, owned by the pool
+        StreamSocket strSock;
+        bool reusable = true;
+    };
+}
+
+#endif // CONNECTIONPOOL_H
@@ -0,0 +1,674 @@
+#include "EventLoop.h"
+//c headers
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+//cpp headers
+#include <cassert>
+//own headers
+#include "ServerSocket.h"
+#include "StreamSocket.h"
+#include "SnlException.h"
+#include "SocketAddress.h"
+
+namespace snl{
+
+    struct EventLoop::Registration{
+        enum class Kind:uint8_t {SERVER = 0, STREAM = 1, WATCH = 2};
+
+        Kind kind;
+        Fd fd; //the fd at the time of registration (the socket no longer knows it after a close)
+        std::uint32_t interest = 0; //the currently registered epoll events
+        bool active = true; //false as soon as the registration is retired
+
+        //server registration
+        ServerSocket* server = nullptr;
+        AcceptCallback onAccept;
+
+        //stream registration
+        std::unique_ptr<StreamSocket> stream;
+        StreamHandlers handlers;
+        bool writeInterest = false;
+
+        //stream deadlines, the last receive time is only recorded, the timers check it when they fire
+        TimerWheel::TimePoint lastActivity;
+        std::chrono::milliseconds idleTimeout{0};
+        TimerId idleTimer = TimerWheel::invalidTimer;
+        StreamCallback onIdle;
+        std::chrono::milliseconds keepAliveInterval{0};
+        TimerId keepAliveTimer = TimerWheel::invalidTimer;
+        StreamCallback onKeepAlive;
+
+        //watch registration, a reader and a writer can wait on the same fd at once (full duplex)
+        struct Waiter{
+            std::uint32_t events = 0;
+            ReadyCallback onReady;
+            bool armed = false; //false once a one shot waiter has fired
+        };
+        Waiter readWaiter; //every watch that does not wait for EPOLLOUT alone
+        Waiter writeWaiter;
+        bool oneShot = true;
+    };
+
+    //helper that checks if the error of the exception only indicates that the call would block
+    static bool isWouldBlock(const SnlException& e){
+        int errorNo = e.getErrorNo();
+        return errorNo == EAGAIN || errorNo == EWOULDBLOCK;
+    }
+
+    EventLoop::EventLoop() : epollFd(makeFdGuard(::epoll_create1, EPOLL_CLOEXEC)), events(defaultMaxEvents), loopTime(TimerWheel::Clock::now()) { }
+
+    EventLoop::~EventLoop() = default; //the owned streams and the epoll fd are closed automatically
+
+    void EventLoop::addServer(ServerSocket& servSock, AcceptCallback onAccept, bool exclusive){
+        if(!servSock.isListening()){
+            throw SnlException("EventLoop error: trying to register a server socket that is not listening");
+        }
+        //the accept loop drains the backlog until EAGAIN, so the socket must never block
+        servSock.setNonBlockIO(true);
+        unwatchFd(servSock.getFd()); //the socket may still be watched by an awaitable
+        //the accept back off needs the timer, it cannot be opened once the process ran out of fds
+        openTimerFd();
+        claimFd(servSock.getFd());
+
+        auto reg = std::make_unique<Registration>();
+        reg->kind = Registration::Kind::SERVER;
+        reg->fd = servSock.getFd();
+        reg->interest = exclusive ? (EPOLLIN | EPOLLEXCLUSIVE) : EPOLLIN;
+        reg->server = &servSock;
+        reg->onAccept = std::move(onAccept);
+
+        epoll_event event{};
+        event.events = reg->interest;
+        event.data.fd = reg->fd;
+        int failure = -1;
+        executeSyscall(::epoll_ctl, failure, epollFd.get(), EPOLL_CTL_ADD, reg->fd, &event);
+
+        registrations[reg->fd] = std::move(reg);
+    }
+
+    void EventLoop::removeServer(ServerSocket& servSock){
+        auto regIt = registrations.find(servSock.getFd());
+        if(regIt == registrations.end() || regIt->second->kind != Registration::Kind::SERVER){
+            throw SnlException("EventLoop error: trying to remove a server socket that is not registered");
+        }
+        retire(regIt->first);
+    }
+
+    StreamSocket& EventLoop::addStream(StreamSocket&& strSock, StreamHandlers handlers){
+        if(!strSock.isConnected()){
+            throw SnlException("EventLoop error: trying to register a stream socket that is not connected");
+        }
+        strSock.setNonBlockIO(true);
+        unwatchFd(strSock.getFd()); //the socket may still be watched by an awaitable or a connect
+        claimFd(strSock.getFd());
+
+        auto reg = std::make_unique<Registration>();
+        reg->kind = Registration::Kind::STREAM;
+        reg->fd = strSock.getFd();
+        reg->stream = std::make_unique<StreamSocket>(std::move(strSock));
+        reg->handlers = std::move(handlers);
+        reg->interest = streamInterest(*reg->stream, reg->writeInterest);
+        reg->lastActivity = loopTime;
+
+        epoll_event event{};
+        event.events = reg->interest;
+        event.data.fd = reg->fd;
+        int failure = -1;
+        executeSyscall(::epoll_ctl, failure, epollFd.get(), EPOLL_CTL_ADD, reg->fd, &event);
+
+        StreamSocket& owned = *reg->stream;
+        registrations[reg->fd] = std::move(reg);
+        streamCount++;
+        return owned;
+    }
+
+    void EventLoop::watchWritable(StreamSocket& strSock, bool writeInterest){
+        Registration& reg = findStream(strSock);
+        reg.writeInterest = writeInterest;
+        syncInterest(reg);
+    }
+
+    void EventLoop::removeStream(StreamSocket& strSock){
+        retire(findStream(strSock).fd);
+        //outside of a dispatch the stream can be destroyed right away
+        if(!dispatching){
+            retired.clear();
+        }
+    }
+
+    void EventLoop::connectAsync(const SocketAddress& sockAddr, std::chrono::milliseconds timeout, ConnectCallback onConnect){
+        //shared by the writable watch and the timeout, whichever comes first completes the connect
+        struct PendingConnect{
+            StreamSocket strSock;
+            Fd fd = -1;
+            TimerId timer = TimerWheel::invalidTimer;
+            ConnectCallback onConnect;
+            bool done = false;
+        };
+        auto pending = std::make_shared<PendingConnect>();
+        pending->onConnect = std::move(onConnect);
+        pending->strSock.setNonBlockIO(true);
+
+        bool connected = false;
+        try{
+            connected = pending->strSock.beginConnect(sockAddr);
+        }catch(SnlException& e){
+            //report through the loop, like every other outcome
+            std::error_code error(e.getErrorNo(), std::system_category());
+            runAfter(std::chrono::milliseconds(0), [pending, error](EventLoop& loop){
+                pending->onConnect(loop, std::move(pending->strSock), error);
+            });
+            return;
+        }
+        if(connected){
+            runAfter(std::chrono::milliseconds(0), [pending](EventLoop& loop){
+                pending->onConnect(loop, std::move(pending->strSock), std::error_code());
+            });
+            return;
+        }
+
+        pending->fd = pending->strSock.getFd();
+        watchFd(pending->fd, EPOLLOUT, [pending](EventLoop& loop, std::uint32_t){
+            if(pending->done){
+                return;
+            }
+            pending->done = true;
+            loop.cancelTimer(pending->timer);
+            loop.unwatchFd(pending->fd);
+
+            std::error_code error;
+            try{
+                pending->strSock.finishConnect();
+            }catch(SnlException& e){
+                error = std::error_code(e.getErrorNo(), std::system_category());
+            }
+            pending->onConnect(loop, std::move(pending->strSock), error);
+        });
+        pending->timer = runAfter(timeout, [pending](EventLoop& loop){
+            if(pending->done){
+                return;
+            }
+            pending->done = true;
+            loop.unwatchFd(pending->fd);
+            pending->strSock.reset(); //abandons the connect in progress and closes the fd
+            pending->onConnect(loop, std::move(pending->strSock), std::make_error_code(std::errc::timed_out));
+        });
+    }
+
+    EventLoop::TimerId EventLoop::runAfter(std::chrono::milliseconds delay, TimerCallback callback){
+        TimerId timerId = timers.add(TimerWheel::Clock::now() + delay, [this, callback = std::move(callback)](){ callback(*this); });
+        armTimerFd();
+        return timerId;
+    }
+
+    bool EventLoop::cancelTimer(TimerId timerId) noexcept{
+        //the timerfd is left armed, an early wakeup without expired timers is harmless
+        return timers.cancel(timerId);
+    }
+
+    void EventLoop::setIdleTimeout(StreamSocket& strSock, std::chrono::milliseconds timeout, StreamCallback onIdle){
+        Registration& reg = findStream(strSock);
+        timers.cancel(reg.idleTimer);
+        reg.idleTimer = TimerWheel::invalidTimer;
+        reg.idleTimeout = timeout;
+        reg.onIdle = std::move(onIdle);
+        if(timeout.count() > 0){
+            Registration* regPtr = &reg;
+            reg.idleTimer = timers.add(reg.lastActivity + timeout, [this, regPtr](){ checkIdle(*regPtr); });
+            armTimerFd();
+        }
+    }
+
+    void EventLoop::setKeepAlive(StreamSocket& strSock, std::chrono::milliseconds interval, StreamCallback onKeepAlive){
+        Registration& reg = findStream(strSock);
+        timers.cancel(reg.keepAliveTimer);
+        reg.keepAliveTimer = TimerWheel::invalidTimer;
+        reg.keepAliveInterval = interval;
+        reg.onKeepAlive = std::move(onKeepAlive);
+        if(interval.count() > 0){
+            Registration* regPtr = &reg;
+            reg.keepAliveTimer = timers.add(reg.lastActivity + interval, [this, regPtr](){ checkKeepAlive(*regPtr); });
+            armTimerFd();
+        }
+    }
+
+    void EventLoop::watchFd(Fd fd, std::uint32_t events, ReadyCallback onReady, bool oneShot){
+        auto regIt = registrations.find(fd);
+        bool rearm = regIt != registrations.end() && regIt->second->kind == Registration::Kind::WATCH;
+        if(!rearm && regIt != registrations.end()){
+            throw SnlException("EventLoop error: trying to watch an fd that is already registered");
+        }
+
+        if(!rearm){
+            auto reg = std::make_unique<Registration>();
+            reg->kind = Registration::Kind::WATCH;
+            reg->fd = fd;
+            regIt = registrations.emplace(fd, std::move(reg)).first;
+        }
+        Registration& reg = *regIt->second;
+        Registration::Waiter& waiter = (events & (EPOLLIN | EPOLLOUT)) == EPOLLOUT ? reg.writeWaiter : reg.readWaiter;
+        Registration::Waiter& other = &waiter == &reg.readWaiter ? reg.writeWaiter : reg.readWaiter;
+        waiter.events = events;
+        waiter.onReady = std::move(onReady);
+        waiter.armed = true;
+        reg.oneShot = oneShot;
+
+        //the interest is the union of both waiters, a single modify for the fd
+        epoll_event event{};
+        std::uint32_t interest = waiter.events | (other.armed ? other.events : 0);
+        event.events = oneShot ? (interest | EPOLLONESHOT) : interest;
+        event.data.fd = fd;
+
+        int failure = -1;
+        //a stale watch (the fd was closed and reused) is no longer in the epoll set, fall back to an add
+        if(!rearm || ::epoll_ctl(epollFd.get(), EPOLL_CTL_MOD, fd, &event) == -1){
+            if(rearm && errno != ENOENT){
+                throw SnlException("EventLoop error: ", errno);
+            }
+            if(rearm){
+                //the other waiter belonged to the closed fd, it must never be resumed for the new one
+                other = Registration::Waiter{};
+                event.events = oneShot ? (waiter.events | EPOLLONESHOT) : waiter.events;
+            }
+            executeSyscall(::epoll_ctl, failure, epollFd.get(), EPOLL_CTL_ADD, fd, &event);
+        }
+        reg.interest = event.events;
+    }
+
+    void EventLoop::unwatchFd(Fd fd){
+        auto regIt = registrations.find(fd);
+        if(regIt == registrations.end() || regIt->second->kind != Registration::Kind::WATCH){
+            return;
+        }
+        retire(fd);
+    }
+
+    std::size_t EventLoop::runOnce(int timeoutMs){
+        int nbEvents = ::epoll_wait(epollFd.get(), events.data(), static_cast<int>(events.size()), timeoutMs);
+        if(nbEvents == -1){
+            if(errno == EINTR){
+                return 0; //interrupted by a signal, nothing to dispatch
+            }
+            throw SnlException("EventLoop error: ", errno);
+        }
+        loopTime = TimerWheel::Clock::now();
+
+        //defer the destruction of streams removed by the callbacks, also when a callback throws
+        struct DispatchScope{
+            EventLoop& loop;
+            explicit DispatchScope(EventLoop& loop_) : loop(loop_) { loop.dispatching = true; }
+            ~DispatchScope(){
+                loop.dispatching = false;
+                loop.retired.clear();
+            }
+        } dispatchScope(*this);
+        for(int i = 0; i != nbEvents; i++){
+            dispatch(events[i]);
+        }
+
+        return static_cast<std::size_t>(nbEvents);
+    }
+
+    void EventLoop::run(){
+        running = true;
+        while(running){
+            runOnce();
+        }
+    }
+
+    void EventLoop::stop() noexcept{
+        running = false;
+    }
+
+    std::size_t EventLoop::getStreamCount() const noexcept{
+        return streamCount;
+    }
+
+    void EventLoop::dispatch(const epoll_event& event){
+        auto regIt = registrations.find(event.data.fd);
+        if(regIt == registrations.end()){
+            return; //retired earlier in this batch
+        }
+
+        Registration& reg = *regIt->second;
+        switch(reg.kind){
+            case Registration::Kind::SERVER:
+                dispatchAccept(reg);
+                break;
+            case Registration::Kind::STREAM:
+                dispatchStream(reg, event.events);
+                break;
+            case Registration::Kind::WATCH:
+                dispatchWatch(reg, event.events);
+                break;
+        }
+    }
+
+    void EventLoop::dispatchAccept(Registration& reg){
+        //drain the backlog in one batch, the socket is non blocking so the batch stops when it is empty
+        std::vector<StreamSocket> accepted;
+        accepted.swap(acceptBuffer); //reuse the storage of the previous batch
+        try{
+            reg.server->acceptBatch(accepted);
+        }catch(SnlException& e){
+            int errorNo = e.getErrorNo();
+            if(errorNo != EMFILE && errorNo != ENFILE && errorNo != ENOBUFS && errorNo != ENOMEM){
+                acceptBuffer.swap(accepted);
+                throw;
+            }
+            //out of fds or memory: the clients stay in the backlog, retrying right away would spin the loop
+            pauseAccept(reg);
+        }
+        for(StreamSocket& strSock : accepted){
+            if(!reg.active){
+                break; //the server was removed by a callback, the rest of the batch is closed
+            }
+            reg.onAccept(*this, std::move(strSock));
+        }
+        accepted.clear();
+        acceptBuffer.swap(accepted);
+    }
+
+    void EventLoop::pauseAccept(Registration& reg){
+        //an EPOLLEXCLUSIVE registration can not be modified, it is removed and added again afterwards
+        epoll_event event{};
+        event.data.fd = reg.fd;
+        int failure = -1;
+        if(reg.interest & EPOLLEXCLUSIVE){
+            executeSyscall(::epoll_ctl, failure, epollFd.get(), EPOLL_CTL_DEL, reg.fd, nullptr);
+        }else{
+            executeSyscall(::epoll_ctl, failure, epollFd.get(), EPOLL_CTL_MOD, reg.fd, &event); //no events: disarmed
+        }
+
+        Fd fd = reg.fd;
+        ServerSocket* server = reg.server;
+        runAfter(acceptBackoff, [fd, server](EventLoop& loop){
+            //the server may have been removed (or its fd reused) during the back off
+            auto regIt = loop.registrations.find(fd);
+            if(regIt == loop.registrations.end() || regIt->second->kind != Registration::Kind::SERVER || regIt->second->server != server){
+                return;
+            }
+            epoll_event event{};
+            event.events = regIt->second->interest;
+            event.data.fd = fd;
+            if(event.events & EPOLLEXCLUSIVE){
+                ::epoll_ctl(loop.epollFd.get(), EPOLL_CTL_ADD, fd, &event);
+            }else{
+                ::epoll_ctl(loop.epollFd.get(), EPOLL_CTL_MOD, fd, &event);
+            }
+        });
+    }
+
+    void EventLoop::dispatchStream(Registration& reg, std::uint32_t readyEvents){
+        StreamSocket& strSock = *reg.stream;
+        bool hangup = (readyEvents & (EPOLLHUP | EPOLLERR)) != 0;
+        if(readyEvents & (EPOLLIN | EPOLLRDHUP)){
+            reg.lastActivity = loopTime; //checked by the idle and keep alive timers
+        }
+
+        try{
+            if(hangup && reg.handlers.onHangup){
+                reg.handlers.onHangup(*this, strSock);
+            }else if((readyEvents & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && reg.handlers.onReadable && !strSock.downStreamClosed()){
+                reg.handlers.onReadable(*this, strSock);
+            }
+
+            if(reg.active && (readyEvents & EPOLLOUT) && reg.writeInterest && reg.handlers.onWritable && !strSock.isClosed()){
+                reg.handlers.onWritable(*this, strSock);
+            }
+        }catch(SnlException& e){
+            //a spurious wakeup is not an error, anything else ends the connection
+            if(!isWouldBlock(e) && !strSock.isClosed()){
+                strSock.close();
+            }
+        }
+
+        if(!reg.active){
+            return; //removed by the callback
+        }
+
+        //after a hangup no further io is possible, the loop closes the socket
+        if(hangup && !strSock.isClosed()){
+            strSock.close();
+        }
+
+        syncInterest(reg);
+    }
+
+    void EventLoop::dispatchWatch(Registration& reg, std::uint32_t readyEvents){
+        //an error or hangup concerns both directions, the waiters find out through their next call
+        std::uint32_t errorEvents = readyEvents & (EPOLLERR | EPOLLHUP);
+        if(!reg.oneShot){
+            if(reg.readWaiter.armed && (readyEvents & reg.readWaiter.events || errorEvents)){
+                reg.readWaiter.onReady(*this, readyEvents);
+            }
+            if(reg.active && reg.writeWaiter.armed && (readyEvents & reg.writeWaiter.events || errorEvents)){
+                reg.writeWaiter.onReady(*this, readyEvents);
+            }
+            return;
+        }
+
+        //the callbacks typically re-arm their waiter (replacing onReady), so they must not run from the registration
+        ReadyCallback onRead;
+        ReadyCallback onWrite;
+        if(reg.readWaiter.armed && (readyEvents & reg.readWaiter.events || errorEvents)){
+            reg.readWaiter.armed = false;
+            onRead = std::move(reg.readWaiter.onReady);
+        }
+        if(reg.writeWaiter.armed && (readyEvents & reg.writeWaiter.events || errorEvents)){
+            reg.writeWaiter.armed = false;
+            onWrite = std::move(reg.writeWaiter.onReady);
+        }
+
+        //the one shot disarmed the whole fd, a re-arm from a callback (watchFd) arms it for both waiters again
+        reg.interest = 0;
+        if(onRead){
+            onRead(*this, readyEvents);
+        }
+        if(onWrite && reg.active){
+            onWrite(*this, readyEvents);
+        }
+        //a waiter that did not fire and was not re-armed by a callback must still be armed
+        if(reg.active && reg.interest == 0 && (reg.readWaiter.armed || reg.writeWaiter.armed)){
+            epoll_event event{};
+            event.events = (reg.readWaiter.armed ? reg.readWaiter.events : 0) | (reg.writeWaiter.armed ? reg.writeWaiter.events : 0) | EPOLLONESHOT;
+            event.data.fd = reg.fd;
+            //the fd may have been closed by a callback, then there is nothing left to arm
+            if(::epoll_ctl(epollFd.get(), EPOLL_CTL_MOD, reg.fd, &event) == 0){
+                reg.interest = event.events;
+            }
+        }
+    }
+
+    void EventLoop::fireTimers(){
+        std::uint64_t expirations = 0;
+        //drain the timerfd, nothing to read on an early wakeup (EAGAIN) and that is fine
+        ::read(timerFd.get(), &expirations, sizeof(expirations));
+        armedWakeup = TimerWheel::TimePoint::max();
+        timers.advance(loopTime);
+        armTimerFd();
+    }
+
+    void EventLoop::armTimerFd(){
+        std::optional<TimerWheel::TimePoint> wakeup = timers.nextWakeup();
+        //a later wakeup is handled by re-arming when the current one fires
+        if(!wakeup || *wakeup >= armedWakeup){
+            return;
+        }
+
+        openTimerFd();
+
+        //the steady clock is the monotonic clock, so the wakeup can be used as an absolute expiration
+        auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(wakeup->time_since_epoch());
+        itimerspec spec{};
+        spec.it_value.tv_sec = static_cast<time_t>(sinceEpoch.count() / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(sinceEpoch.count() % 1000000000);
+        if(spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0){
+            spec.it_value.tv_nsec = 1; //a zero expiration would disarm the timer
+        }
+        int failure = -1;
+        executeSyscall(::timerfd_settime, failure, timerFd.get(), TFD_TIMER_ABSTIME, &spec, nullptr);
+        armedWakeup = *wakeup;
+    }
+
+    void EventLoop::openTimerFd(){
+        if(!timerFd.ownsFd()){
+            timerFd = makeFdGuard(::timerfd_create, CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            watchFd(timerFd.get(), EPOLLIN, [](EventLoop& loop, std::uint32_t){ loop.fireTimers(); }, false);
+        }
+    }
+
+    void EventLoop::checkIdle(Registration& reg){
+        reg.idleTimer = TimerWheel::invalidTimer;
+        TimerWheel::TimePoint deadline = reg.lastActivity + reg.idleTimeout;
+        if(deadline > loopTime){
+            //data arrived since the timer was started, wait for the remainder
+            Registration* regPtr = &reg;
+            reg.idleTimer = timers.add(deadline, [this, regPtr](){ checkIdle(*regPtr); });
+            return;
+        }
+
+        StreamSocket& strSock = *reg.stream;
+        try{
+            if(reg.onIdle){
+                reg.onIdle(*this, strSock);
+            }else if(!strSock.isClosed()){
+                strSock.close();
+            }
+        }catch(SnlException&){
+            if(!strSock.isClosed()){
+                strSock.close();
+            }
+        }
+
+        if(reg.active){
+            syncInterest(reg);
+        }
+    }
+
+    void EventLoop::checkKeepAlive(Registration& reg){
+        reg.keepAliveTimer = TimerWheel::invalidTimer;
+        TimerWheel::TimePoint deadline = reg.lastActivity + reg.keepAliveInterval;
+        if(deadline <= loopTime){
+            StreamSocket& strSock = *reg.stream;
+            try{
+                reg.onKeepAlive(*this, strSock);
+            }catch(SnlException& e){
+                if(!isWouldBlock(e) && !strSock.isClosed()){
+                    strSock.close();
+                }
+            }
+            if(!reg.active){
+                return;
+            }
+            syncInterest(reg);
+            if(!reg.active){
+                return;
+            }
+            deadline = loopTime + reg.keepAliveInterval; //still quiet, next keep alive after a full interval
+        }
+
+        Registration* regPtr = &reg;
+        reg.keepAliveTimer = timers.add(deadline, [this, regPtr](){ checkKeepAlive(*regPtr); });
+    }
+
+    void EventLoop::cancelStreamTimers(Registration& reg) noexcept{
+        timers.cancel(reg.idleTimer);
+        timers.cancel(reg.keepAliveTimer);
+        reg.idleTimer = TimerWheel::invalidTimer;
+        reg.keepAliveTimer = TimerWheel::invalidTimer;
+    }
+
+    void EventLoop::syncInterest(Registration& reg){
+        StreamSocket& strSock = *reg.stream;
+        if(strSock.isClosed()){
+            //closing the fd already removed it from the epoll set
+            retire(reg.fd);
+            return;
+        }
+
+        std::uint32_t interest = streamInterest(strSock, reg.writeInterest);
+        if(interest == reg.interest){
+            return;
+        }
+
+        epoll_event event{};
+        event.events = interest;
+        event.data.fd = reg.fd;
+        int failure = -1;
+        executeSyscall(::epoll_ctl, failure, epollFd.get(), EPOLL_CTL_MOD, reg.fd, &event);
+        reg.interest = interest;
+    }
+
+    void EventLoop::retire(Fd fd){
+        auto regIt = registrations.find(fd);
+        assert(regIt != registrations.end());
+
+        std::unique_ptr<Registration> reg = std::move(regIt->second);
+        registrations.erase(regIt);
+        reg->active = false;
+
+        if(reg->kind == Registration::Kind::WATCH){
+            //the watched fd may already be closed by its owner, then there is nothing left to remove
+            ::epoll_ctl(epollFd.get(), EPOLL_CTL_DEL, fd, nullptr);
+        }else if(reg->kind == Registration::Kind::SERVER){
+            //an exclusive server that backs off after fd exhaustion is not in the epoll set
+            if(::epoll_ctl(epollFd.get(), EPOLL_CTL_DEL, fd, nullptr) == -1 && errno != ENOENT){
+                throw SnlException("EventLoop error: ", errno);
+            }
+        }else if(!reg->stream->isClosed()){
+            int failure = -1;
+            executeSyscall(::epoll_ctl, failure, epollFd.get(), EPOLL_CTL_DEL, fd, nullptr);
+        }
+        if(reg->kind == Registration::Kind::STREAM){
+            cancelStreamTimers(*reg);
+            streamCount--;
+        }
+
+        retired.push_back(std::move(reg));
+    }
+
+    void EventLoop::claimFd(Fd fd){
+        auto regIt = registrations.find(fd);
+        if(regIt == registrations.end()){
+            return;
+        }
+        //a stream closed outside of its own dispatch left its registration behind, its fd number was reused
+        Registration& reg = *regIt->second;
+        if(reg.kind == Registration::Kind::STREAM && reg.stream->isClosed()){
+            retire(fd); //cancels its timers, they point to the registration
+            return;
+        }
+        throw SnlException("EventLoop error: trying to register an fd that is already registered");
+    }
+
+    EventLoop::Registration& EventLoop::findStream(StreamSocket& strSock){
+        auto regIt = registrations.find(strSock.getFd());
+        if(regIt != registrations.end() && regIt->second->stream.get() == &strSock){
+            return *regIt->second;
+        }
+
+        //the socket was closed outside of the loop, it no longer knows its fd
+        for(auto& entry : registrations){
+            if(entry.second->stream.get() == &strSock){
+                return *entry.second;
+            }
+        }
+
+        throw SnlException("EventLoop error: the stream socket is not owned by this loop");
+    }
+
+    std::uint32_t EventLoop::streamInterest(const StreamSocket& strSock, bool writeInterest){
+        std::uint32_t interest = 0;
+        //a downstream closed socket keeps reporting eof, so stop listening for it
+        if(!strSock.downStreamClosed()){
+            interest |= EPOLLIN | EPOLLRDHUP;
+        }
+        if(writeInterest && !strSock.upstreamClosed()){
+            interest |= EPOLLOUT;
+        }
+        return interest;
+    }
+}
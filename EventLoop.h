@@ -0,0 +1,231 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+//c headers
+#include <sys/epoll.h>
+//cpp headers
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+//own headers
+#include "FdGuard.h"
+#include "TimerWheel.h"
+
+namespace snl{
+
+    //forward declarations
+    class ServerSocket;
+    class StreamSocket;
+    class SocketAddress;
+
+    class EventLoop
+    {
+    public:
+
+        //called for every connection accepted on a registered server socket
+        using AcceptCallback = std::function<void(EventLoop&, StreamSocket&&)>;
+        //called when a registered stream socket is ready
+        using StreamCallback = std::function<void(EventLoop&, StreamSocket&)>;
+        //called when a watched fd is ready, receives the ready epoll events
+        using ReadyCallback = std::function<void(EventLoop&, std::uint32_t)>;
+        //called when a timer expires
+        using TimerCallback = std::function<void(EventLoop&)>;
+        using TimerId = TimerWheel::TimerId;
+        //receives the connected socket, or an error (ETIMEDOUT when the timeout expired) and an unconnected socket
+        using ConnectCallback = std::function<void(EventLoop&, StreamSocket&&, std::error_code)>;
+
+        /**
+         * the callbacks that are attached to a stream socket owned by the loop
+         * onReadable: the socket has data (or an eof) waiting
+         * onWritable: the socket can accept new data (only reported when write interest is set)
+         * onHangup: the peer hung up or the socket is in error, if empty onReadable is called instead
+         */
+        struct StreamHandlers{
+            StreamCallback onReadable;
+            StreamCallback onWritable;
+            StreamCallback onHangup;
+        };
+
+        EventLoop();
+        ~EventLoop();
+
+        EventLoop(const EventLoop& rhs) = delete;
+        EventLoop& operator=(const EventLoop& rhs) = delete;
+
+        /**
+         * @brief registers a server socket with the loop, the loop does not take ownership
+         * @param servSock the listening server socket, will be set to non blocking
+         * @param onAccept the callback that receives every accepted connection
+         * @param exclusive register with EPOLLEXCLUSIVE, when several loops (threads) watch the same
+         *        server socket only one of them is woken up per connection
+         * @throws SnlException if the socket is not listening or could not be registered
+         * note: the server socket must outlive its registration (see removeServer)
+         */
+        void addServer(ServerSocket& servSock, AcceptCallback onAccept, bool exclusive = false);
+
+        /**
+         * @brief removes a previously registered server socket from the loop
+         * @param servSock the server socket to remove
+         */
+        void removeServer(ServerSocket& servSock);
+
+        /**
+         * @brief hands a connected stream socket over to the loop
+         * @param strSock the socket to add, will be set to non blocking
+         * @param handlers the callbacks to invoke when the socket is ready
+         * @return a reference to the socket now owned by the loop, valid until it is removed
+         * @throws SnlException if the socket is not connected or could not be registered
+         */
+        StreamSocket& addStream(StreamSocket&& strSock, StreamHandlers handlers);
+
+        /**
+         * @brief enables or disables the writable notifications of a stream owned by the loop
+         * @param strSock the socket (as returned by addStream)
+         * @param writeInterest true if onWritable must be called when the socket can be written to
+         */
+        void watchWritable(StreamSocket& strSock, bool writeInterest);
+
+        /**
+         * @brief deregisters and destroys a stream owned by the loop
+         * @param strSock the socket (as returned by addStream)
+         * note: safe to call from within a callback, the socket is destroyed after the current dispatch
+         */
+        void removeStream(StreamSocket& strSock);
+
+        /**
+         * @brief connects to the address without blocking the loop
+         * @param sockAddr the address to connect to
+         * @param timeout the maximum time the connect may take
+         * @param onConnect receives the outcome, called from the loop (also when the connect completes immediately)
+         * note: a connect in progress costs one watched fd and one timer
+         */
+        void connectAsync(const SocketAddress& sockAddr, std::chrono::milliseconds timeout, ConnectCallback onConnect);
+        
+        /**
+         * @brief runs the callback once after the delay has passed (with the resolution of the timer wheel)
+         * @return the id of the timer, can be used to cancel it
+         */
+        TimerId runAfter(std::chrono::milliseconds delay, TimerCallback callback);
+
+        /**
+         * @brief cancels a timer started with runAfter
+         * @return false if the timer already fired or was cancelled
+         */
+        bool cancelTimer(TimerId timerId) noexcept;
+
+        /**
+         * @brief closes (or reports) a stream owned by the loop once nothing was received for the timeout
+         * @param strSock the socket (as returned by addStream)
+         * @param timeout the maximum time without incoming data, 0 disables the timeout
+         * @param onIdle called when the stream is idle, if empty the loop closes the stream
+         * note: receiving data only records the time, the deadline is checked lazily when the timer fires
+         */
+        void setIdleTimeout(StreamSocket& strSock, std::chrono::milliseconds timeout, StreamCallback onIdle = {});
+
+        /**
+         * @brief calls onKeepAlive every time nothing was received for the interval (typically to send a ping)
+         * @param strSock the socket (as returned by addStream)
+         * @param interval the keep alive interval, 0 disables the keep alive
+         * @param onKeepAlive the callback that is invoked for a quiet stream
+         */
+        void setKeepAlive(StreamSocket& strSock, std::chrono::milliseconds interval, StreamCallback onKeepAlive);
+
+        /**
+         * @brief watches a file descriptor that is not owned by the loop (used by the coroutine awaitables)
+         * @param fd the fd to watch, the loop does not take ownership
+         * @param events the epoll events to wait for (EPOLLIN, EPOLLOUT, ...)
+         * @param onReady the callback that is invoked when the fd is ready
+         * @param oneShot if true the watch is disarmed after the callback, a new call to watchFd re-arms it
+         *        (cheaper than unwatching and watching again)
+         * note: a watch for EPOLLOUT (without EPOLLIN) and any other watch are kept apart, so a reader and a
+         *       writer can wait on the same fd at the same time, a new watch replaces the one of the same direction
+         * note: an fd that is closed while watched drops out of the epoll set on its own, the stale watch
+         *       is replaced by the next registration of the same fd number
+         */
+        void watchFd(Fd fd, std::uint32_t events, ReadyCallback onReady, bool oneShot = true);
+
+        /**
+         * @brief stops watching an fd registered with watchFd, does nothing if the fd is not watched
+         */
+        void unwatchFd(Fd fd);
+
+        /**
+         * @brief waits for events and dispatches them once
+         * @param timeoutMs the maximum time to wait in milliseconds, -1 waits indefinitely
+         * @return the number of events dispatched
+         */
+        std::size_t runOnce(int timeoutMs = -1);
+
+        /**
+         * @brief dispatches events until stop() is called
+         */
+        void run();
+
+        /**
+         * @brief makes run() return after the current dispatch, may be called from a callback
+         */
+        void stop() noexcept;
+
+        /**
+         * @brief getter for the number of stream sockets currently owned by the loop
+         */
+        std::size_t getStreamCount() const noexcept;
+
+        static constexpr int defaultMaxEvents = 256;
+        //how long a server that hit EMFILE/ENFILE/ENOBUFS/ENOMEM stops accepting
+        static constexpr std::chrono::milliseconds acceptBackoff{100};
+
+    private:
+
+        struct Registration; //the state kept for every registered fd
+
+        //dispatches a single epoll event to the registration of the fd
+        void dispatch(const epoll_event& event);
+        void dispatchAccept(Registration& reg);
+        //drops the stale registration of a closed stream whose fd number is reused, throws for a live one
+        void claimFd(Fd fd);
+        //disarms a server that ran out of fds or memory and arms it again after the back off
+        void pauseAccept(Registration& reg);
+        void dispatchStream(Registration& reg, std::uint32_t events);
+        void dispatchWatch(Registration& reg, std::uint32_t events);
+
+        //timer handling: fires the expired timers and moves the timerfd to the next wakeup
+        void fireTimers();
+        void armTimerFd();
+        void openTimerFd(); //creates and watches the timerfd on first use
+        void checkIdle(Registration& reg);
+        void checkKeepAlive(Registration& reg);
+        void cancelStreamTimers(Registration& reg) noexcept;
+
+        //recomputes the epoll interest of a stream based on the state of its fsm
+        //and deregisters the stream if it is closed
+        void syncInterest(Registration& reg);
+
+        //removes the registration of the fd and schedules it for destruction
+        void retire(Fd fd);
+
+        //finds the registration of a stream owned by the loop, throws if not found
+        Registration& findStream(StreamSocket& strSock);
+
+        static std::uint32_t streamInterest(const StreamSocket& strSock, bool writeInterest);
+
+        FdGuard epollFd;
+        std::unordered_map<Fd, std::unique_ptr<Registration>> registrations;
+        //registrations removed during a dispatch, destroyed after the dispatch is complete
+        std::vector<std::unique_ptr<Registration>> retired;
+        std::vector<epoll_event> events;
+        std::vector<StreamSocket> acceptBuffer; //storage for the batch accepts
+
+        TimerWheel timers;
+        FdGuard timerFd; //created on the first timer
+        TimerWheel::TimePoint armedWakeup = TimerWheel::TimePoint::max(); //the expiration the timerfd is set to
+        TimerWheel::TimePoint loopTime; //the time after the last wait, avoids a clock read per event
+        std::size_t streamCount = 0;
+        bool running = false;
+        bool dispatching = false;
+    };
+}
+
+#endif // EVENTLOOP_H
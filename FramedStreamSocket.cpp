@@ -0,0 +1,192 @@
+#include "FramedStreamSocket.h"
+//c headers
+#include <cerrno>
+#include <poll.h>
+#include <sys/uio.h>
+//cpp headers
+#include <algorithm>
+#include <cstdint>
+//own headers
+#include "SnlException.h"
+
+namespace snl{
+
+    //the largest payload the header can describe
+    static std::size_t headerLimit(FrameHeader headerType){
+        switch(headerType){
+            case FrameHeader::fixed16: return 0xffff;
+            case FrameHeader::fixed32: return 0xffffffff;
+            default: return SIZE_MAX;
+        }
+    }
+
+    //the ring holds two maximum sized frames with their headers
+    static std::size_t ringCapacity(std::size_t maxFrameSize){
+        if(maxFrameSize > SIZE_MAX / 2 - FramedStreamSocket::maxHeaderSize){
+            throw SnlException("FramedStreamSocket error: the maximum frame size overflows the ring size: ", EMSGSIZE);
+        }
+        return 2 * (maxFrameSize + FramedStreamSocket::maxHeaderSize);
+    }
+
+    //decodes the header at the front of the data
+    //returns false if the header is not completely there yet, throws on a malformed header
+    static bool decodeHeader(FrameHeader headerType, std::string_view data, std::size_t& headerSize, std::size_t& payloadSize){
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+        switch(headerType){
+            case FrameHeader::fixed16:
+                if(data.size() < 2){
+                    return false;
+                }
+                headerSize = 2;
+                payloadSize = (std::size_t(bytes[0]) << 8) | bytes[1];
+                return true;
+            case FrameHeader::fixed32:
+                if(data.size() < 4){
+                    return false;
+                }
+                headerSize = 4;
+                payloadSize = (std::size_t(bytes[0]) << 24) | (std::size_t(bytes[1]) << 16) | (std::size_t(bytes[2]) << 8) | bytes[3];
+                return true;
+            default:
+                break;
+        }
+
+        std::uint64_t value = 0;
+        for(std::size_t index = 0; index != FramedStreamSocket::maxHeaderSize; ++index){
+            if(index == data.size()){
+                return false;
+            }
+            value |= std::uint64_t(bytes[index] & 0x7f) << (7 * index);
+            if((bytes[index] & 0x80) == 0){
+                headerSize = index + 1;
+                payloadSize = value;
+                return true;
+            }
+        }
+        throw SnlException("FramedStreamSocket error: malformed varint header: ", EPROTO);
+    }
+
+    FramedStreamSocket::FramedStreamSocket(StreamSocket& strSock_, FrameHeader headerType_, std::size_t maxFrameSize_) :
+        strSock(strSock_), ring(ringCapacity(std::min(maxFrameSize_, headerLimit(headerType_)))),
+        headerType(headerType_), maxFrameSize(std::min(maxFrameSize_, headerLimit(headerType_))) { }
+
+    void FramedStreamSocket::sendFrame(const void* payload, std::size_t payloadSize){
+        if(payloadSize > maxFrameSize){
+            throw SnlException("FramedStreamSocket error: the payload exceeds the maximum frame size: ", EMSGSIZE);
+        }
+        char header[maxHeaderSize];
+        const iovec segments[] = {
+            {header, encodeHeader(headerType, payloadSize, header)},
+            {const_cast<void*>(payload), payloadSize}
+        };
+        sendAllv(strSock, segments);
+    }
+
+    void FramedStreamSocket::sendFrame(std::string_view payload){ sendFrame(payload.data(), payload.size()); }
+
+    std::string_view FramedStreamSocket::receiveFrame(){
+        std::string_view frame;
+        while(!nextFrame(frame)){
+            fill(true);
+        }
+        return frame;
+    }
+
+    bool FramedStreamSocket::tryReceiveFrame(std::string_view& frame){
+        //keep receiving while data is there, an edge triggered loop is not woken up again for the rest
+        while(!nextFrame(frame)){
+            if(!fill(false)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void FramedStreamSocket::releaseFrames() noexcept{
+        ring.consume(heldSize);
+        heldSize = 0;
+    }
+
+    std::size_t FramedStreamSocket::encodeHeader(FrameHeader headerType, std::size_t payloadSize, char (&buffer)[maxHeaderSize]) noexcept{
+        switch(headerType){
+            case FrameHeader::fixed16:
+                buffer[0] = static_cast<char>(payloadSize >> 8);
+                buffer[1] = static_cast<char>(payloadSize);
+                return 2;
+            case FrameHeader::fixed32:
+                buffer[0] = static_cast<char>(payloadSize >> 24);
+                buffer[1] = static_cast<char>(payloadSize >> 16);
+                buffer[2] = static_cast<char>(payloadSize >> 8);
+                buffer[3] = static_cast<char>(payloadSize);
+                return 4;
+            default:
+                break;
+        }
+
+        std::size_t headerSize = 0;
+        do{
+            char byte = static_cast<char>(payloadSize & 0x7f);
+            payloadSize >>= 7;
+            buffer[headerSize++] = payloadSize != 0 ? static_cast<char>(byte | 0x80) : byte;
+        }while(payloadSize != 0);
+        return headerSize;
+    }
+
+    std::size_t FramedStreamSocket::getMaxFrameSize() const noexcept{
+        return maxFrameSize;
+    }
+
+    std::size_t FramedStreamSocket::getHeldSize() const noexcept{
+        return heldSize;
+    }
+
+    StreamSocket& FramedStreamSocket::getSocket() noexcept{
+        return strSock;
+    }
+
+    bool FramedStreamSocket::nextFrame(std::string_view& frame){
+        std::string_view unread = ring.getReadable().substr(heldSize);
+        std::size_t headerSize = 0;
+        std::size_t payloadSize = 0;
+        if(!decodeHeader(headerType, unread, headerSize, payloadSize)){
+            return false;
+        }
+        if(payloadSize > maxFrameSize){
+            throw SnlException("FramedStreamSocket error: the frame exceeds the maximum frame size: ", EMSGSIZE);
+        }
+        if(unread.size() - headerSize < payloadSize){
+            return false;
+        }
+
+        //the view points into the ring, the bytes stay there until the frame is released
+        frame = unread.substr(headerSize, payloadSize);
+        heldSize += headerSize + payloadSize;
+        return true;
+    }
+
+    bool FramedStreamSocket::fill(bool wait){
+        std::span<char> writable = ring.getWritable();
+        if(writable.empty()){
+            throw SnlException("FramedStreamSocket error: the held frames leave no room for the next frame: ", ENOBUFS);
+        }
+
+        std::size_t bytesReceived = 0;
+        if(wait && !strSock.isNonBlock()){
+            bytesReceived = strSock.receive(writable.data(), writable.size());
+        }else{
+            while(!strSock.tryReceive(writable.data(), writable.size(), bytesReceived)){
+                if(!wait){
+                    return false;
+                }
+                pollfd pollFd{strSock.getFd(), POLLIN, 0};
+                while(::poll(&pollFd, 1, -1) == -1){
+                    if(errno != EINTR){
+                        throw SnlException("FramedStreamSocket error: ", errno);
+                    }
+                }
+            }
+        }
+        ring.commit(bytesReceived);
+        return true;
+    }
+}
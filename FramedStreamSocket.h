@@ -0,0 +1,103 @@
+#ifndef FRAMEDSTREAMSOCKET_H
+#define FRAMEDSTREAMSOCKET_H
+//c headers
+//cpp headers
+#include <string_view>
+//own headers
+#include "MirroredRingBuffer.h"
+#include "StreamSocket.h"
+
+namespace snl{
+
+    /**
+     * the encoding of the length header in front of every frame
+     * the fixed headers are in network byte order, the varint is the LEB128 encoding (7 bits per byte, low bits first)
+     */
+    enum class FrameHeader{
+        varint,
+        fixed16,
+        fixed32
+    };
+
+    /**
+     * Length prefixed framing on top of a connected stream socket
+     * every frame is a length header followed by the payload, so binary payloads need no escaping and the receiver
+     * needs no delimiter scan. The header and the payload of a frame are sent with a single gather send.
+     * The frames are received into a mirrored ring buffer and handed out as views that point straight into it:
+     * a view stays valid until the frames are released, receiving more frames does not move the held ones.
+     * note: the framed socket owns the receive side of the socket, mixing it with direct receives loses the buffered bytes
+     * note: sendFrame and receiveFrame block until done (independent of the socket non blocking behavior),
+     *       use tryReceiveFrame on an event loop
+     */
+    class FramedStreamSocket
+    {
+    public:
+
+        static constexpr std::size_t defaultMaxFrameSize = 1024 * 1024;
+        static constexpr std::size_t maxHeaderSize = 10; //a varint of a 64 bit length
+
+        /**
+         * @param strSock the socket to frame, must outlive the framed socket
+         * @param headerType the encoding of the length header (both sides must use the same one)
+         * @param maxFrameSize the largest payload that is sent or accepted (limited by the header type)
+         * @throws SnlException with EMSGSIZE if the ring size for the maximum frame size overflows
+         * note: the ring buffer holds at least two maximum sized frames, so a held frame never blocks the next one
+         */
+        explicit FramedStreamSocket(StreamSocket& strSock, FrameHeader headerType = FrameHeader::varint, std::size_t maxFrameSize = defaultMaxFrameSize);
+
+        FramedStreamSocket(const FramedStreamSocket& rhs) = delete;
+        FramedStreamSocket& operator=(const FramedStreamSocket& rhs) = delete;
+
+        /**
+         * @brief sends the header and the payload as one frame
+         * @throws SnlException with EMSGSIZE if the payload exceeds the maximum frame size
+         */
+        void sendFrame(const void* payload, std::size_t payloadSize);
+        void sendFrame(std::string_view payload);
+
+        /**
+         * @brief receives the next frame
+         * @return the payload, valid until releaseFrames is called
+         * @throws SnlException with EMSGSIZE if the frame exceeds the maximum size, EPROTO on a malformed header,
+         *         ENOBUFS if the held frames leave no room for the next one, SnlEofException if the stream ends first
+         */
+        std::string_view receiveFrame();
+
+        /**
+         * @brief receives the next frame if the data for it is available without blocking
+         * @return false if the call would block (the partial frame stays buffered for the next call)
+         * note: the socket should be non blocking, a blocking socket blocks in the receive
+         */
+        bool tryReceiveFrame(std::string_view& frame);
+
+        /**
+         * @brief releases all the frames handed out so far, their views become invalid
+         */
+        void releaseFrames() noexcept;
+
+        /**
+         * @brief encodes the header of a payload of payloadSize bytes into the buffer
+         * @return the size of the header
+         */
+        static std::size_t encodeHeader(FrameHeader headerType, std::size_t payloadSize, char (&buffer)[maxHeaderSize]) noexcept;
+
+        std::size_t getMaxFrameSize() const noexcept;
+        std::size_t getHeldSize() const noexcept;
+        StreamSocket& getSocket() noexcept;
+
+    private:
+
+        //hands out the next frame if it is completely buffered
+        bool nextFrame(std::string_view& frame);
+        //receives once into the free space of the ring, returns false if it would block
+        bool fill(bool wait);
+
+        StreamSocket& strSock;
+        MirroredRingBuffer ring;
+        FrameHeader headerType;
+        std::size_t maxFrameSize;
+        std::size_t heldSize = 0; //bytes at the front of the ring that belong to frames handed out
+    };
+}
+
+#endif // FRAMEDSTREAMSOCKET_H
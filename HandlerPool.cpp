@@ -0,0 +1,150 @@
+#include "HandlerPool.h"
+//c headers
+//cpp headers
+#include <deque>
+//own headers
+#include "StreamSocket.h"
+#include "SnlException.h"
+
+namespace snl{
+
+    struct HandlerPool::Worker{
+        mutable std::mutex queueMutex;
+        std::deque<StreamSocket> queue; //guarded by the queue mutex
+        std::atomic<std::size_t> handled{0};
+        std::atomic<std::size_t> steals{0};
+        std::atomic<std::size_t> failures{0};
+    };
+
+    HandlerPool::HandlerPool(Handler handler_, std::size_t nbThreads) : handler(std::move(handler_)){
+        if(nbThreads == 0){
+            throw SnlException("HandlerPool error: the pool needs at least one thread");
+        }
+
+        workers.reserve(nbThreads);
+        for(std::size_t i = 0; i != nbThreads; i++){
+            workers.push_back(std::make_unique<Worker>());
+        }
+        //start the threads after all the workers exist, they steal from each other
+        threads.reserve(nbThreads);
+        for(std::size_t i = 0; i != nbThreads; i++){
+            threads.emplace_back(&HandlerPool::workerLoop, this, i);
+        }
+    }
+
+    HandlerPool::~HandlerPool(){
+        shutdown();
+    }
+
+    void HandlerPool::submit(StreamSocket&& strSock){
+        Worker& worker = *workers[nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size()];
+        {
+            //push and count under the sleep mutex: a worker cannot miss the wakeup and the shutdown cannot
+            //slip in between the check and the push (which would leave the socket unhandled)
+            std::lock_guard<std::mutex> sleepLock(sleepMutex);
+            if(stopping){
+                throw SnlException("HandlerPool error: submitting a connection to a pool that is shut down");
+            }
+            //counted after the push under the queue mutex, a worker never sees a count without a socket
+            //and the count never drops below zero when the socket is taken right away
+            std::lock_guard<std::mutex> queueLock(worker.queueMutex);
+            worker.queue.push_back(std::move(strSock));
+            queued.fetch_add(1, std::memory_order_relaxed);
+        }
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        sleepCondition.notify_one();
+    }
+
+    void HandlerPool::shutdown(){
+        {
+            std::lock_guard<std::mutex> sleepLock(sleepMutex);
+            stopping = true;
+        }
+        sleepCondition.notify_all();
+
+        for(std::thread& thread : threads){
+            if(thread.joinable()){
+                thread.join();
+            }
+        }
+    }
+
+    void HandlerPool::workerLoop(std::size_t index){
+        Worker& worker = *workers[index];
+        while(true){
+            std::optional<StreamSocket> strSock = takeWork(index);
+            if(strSock){
+                try{
+                    handler(*strSock);
+                }catch(SnlException&){
+                    //the connection failed (peer left, reset, ...), the worker moves on
+                    worker.failures.fetch_add(1, std::memory_order_relaxed);
+                }catch(...){
+                    //any other exception (std::exception or not) is a bug in the handler, it must not take
+                    //the worker (and with it the process) down
+                    worker.failures.fetch_add(1, std::memory_order_relaxed);
+                }
+                worker.handled.fetch_add(1, std::memory_order_relaxed);
+                continue; //the socket is destroyed (closed) before the next one is taken
+            }
+
+            std::unique_lock<std::mutex> sleepLock(sleepMutex);
+            sleepCondition.wait(sleepLock, [this](){ return stopping || queued.load(std::memory_order_relaxed) != 0; });
+            if(stopping && queued.load(std::memory_order_relaxed) == 0){
+                return; //all the queued connections are handled
+            }
+        }
+    }
+
+    std::optional<StreamSocket> HandlerPool::takeWork(std::size_t index){
+        //own deque first, oldest connection first
+        Worker& own = *workers[index];
+        {
+            std::lock_guard<std::mutex> queueLock(own.queueMutex);
+            if(!own.queue.empty()){
+                std::optional<StreamSocket> strSock(std::move(own.queue.front()));
+                own.queue.pop_front();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return strSock;
+            }
+        }
+
+        //then steal from the back of the other deques, starting at the next worker to spread the thieves
+        for(std::size_t offset = 1; offset != workers.size(); offset++){
+            Worker& victim = *workers[(index + offset) % workers.size()];
+            std::lock_guard<std::mutex> queueLock(victim.queueMutex);
+            if(!victim.queue.empty()){
+                std::optional<StreamSocket> strSock(std::move(victim.queue.back()));
+                victim.queue.pop_back();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                own.steals.fetch_add(1, std::memory_order_relaxed);
+                return strSock;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    HandlerPool::Stats HandlerPool::getStats() const{
+        Stats stats;
+        stats.queueDepths.reserve(workers.size());
+        stats.handled.reserve(workers.size());
+        stats.steals.reserve(workers.size());
+        stats.failures.reserve(workers.size());
+        for(const auto& worker : workers){
+            {
+                std::lock_guard<std::mutex> queueLock(worker->queueMutex);
+                stats.queueDepths.push_back(worker->queue.size());
+            }
+            stats.handled.push_back(worker->handled.load(std::memory_order_relaxed));
+            stats.steals.push_back(worker->steals.load(std::memory_order_relaxed));
+            stats.failures.push_back(worker->failures.load(std::memory_order_relaxed));
+        }
+        stats.submitted = submitted.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    std::size_t HandlerPool::getThreadCount() const noexcept{
+        return workers.size();
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef HANDLERPOOL_H
+#define HANDLERPOOL_H
+//c headers
+//cpp headers
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+//own headers
+
+namespace snl{
+
+    //forward declarations
+    class StreamSocket;
+
+    /**
+     * Work stealing pool of handler threads for accepted connections
+     * every worker owns a deque of sockets, submitted sockets are spread round robin over the deques.
+     * A worker handles the sockets of its own deque (oldest first) and when it runs dry it steals the
+     * newest socket from another worker, so a worker stuck on a slow client does not hold up the
+     * connections queued behind it.
+     */
+    class HandlerPool
+    {
+    public:
+
+        using Handler = std::function<void(StreamSocket&)>;
+
+        /**
+         * snapshot of the pool counters, the vectors are indexed by worker
+         */
+        struct Stats{
+            std::vector<std::size_t> queueDepths; //sockets currently waiting in the deque of the worker
+            std::vector<std::size_t> handled; //sockets handled by the worker
+            std::vector<std::size_t> steals; //sockets the worker took from the deque of another worker
+            std::vector<std::size_t> failures; //handler calls of the worker that ended in an exception
+            std::size_t submitted = 0; //sockets submitted to the pool
+        };
+
+        /**
+         * @brief starts the worker threads
+         * @param handler the function that handles a connection, called on a worker thread
+         * @param threads the number of workers
+         * note: an exception escaping the handler only ends the connection it was handling, the
+         *       connection is counted in the failures of the worker
+         */
+        HandlerPool(Handler handler, std::size_t threads);
+
+        /**
+         * @brief shuts down the pool (see shutdown)
+         */
+        ~HandlerPool();
+
+        HandlerPool(const HandlerPool& rhs) = delete;
+        HandlerPool& operator=(const HandlerPool& rhs) = delete;
+
+        /**
+         * @brief queues a connection to be handled by one of the workers
+         * @throws SnlException if the pool is shut down
+         */
+        void submit(StreamSocket&& strSock);
+
+        /**
+         * @brief handles the connections that are still queued and joins the workers
+         */
+        void shutdown();
+
+        Stats getStats() const;
+        std::size_t getThreadCount() const noexcept;
+
+    private:
+
+        struct Worker; //the deque and the counters of a worker thread
+
+        void workerLoop(std::size_t index);
+        //takes a socket from the deque of the worker, or steals one from another worker
+        std::optional<StreamSocket> takeWork(std::size_t index);
+
+        Handler handler;
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+
+        std::atomic<std::size_t> nextWorker{0}; //round robin submit index
+        std::atomic<std::size_t> queued{0}; //sockets waiting in any of the deques
+        std::atomic<std::size_t> submitted{0};
+
+        //idle workers sleep here until work is queued
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+        bool stopping = false; //guarded by the sleep mutex
+    };
+}
+
+#endif // HANDLERPOOL_H
@@ -3,6 +3,7 @@
 //cpp headers
 #include <iostream>
 #include <cassert>
+#include <cstring>
 //c headers
 #include <arpa/inet.h> // for inet_ntop and inet_pton
 #include <sys/types.h> // for all kinds of system related stuff (typedefs)
@@ -11,139 +12,22 @@
 //own headers
 #include "SnlException.h" //used for the exceptions thrown by ip address creation
 #include "TcpPort.h"
+#include "Resolver.h"
 namespace snl{
     
     enum class IpAddress::IpVersion {IPV6 = AF_INET6, IPV4 = AF_INET}; //definition of ip version
     
-   /*
-    * Implementation of the pimpl classes
-    */ 
-    
-    //declation and definition of the ip impl
-    class IpAddress::IpImpl{
-    public:
-        IpImpl(IpVersion version) : ipVersion(version) {}
-        IpVersion getIpVersion() const{
-            return ipVersion;
-        }
-        virtual std::string getIpString() const = 0;
-        virtual sockaddr_storage getSockaddrStorage(TcpPort tcpPort) const = 0;
-        virtual std::unique_ptr<IpImpl> copy() const = 0;
-        virtual ~IpImpl() = default;
-    private:    
-        IpVersion ipVersion;
-    };
-    
-    class IpAddress::Ipv6Impl : public IpAddress::IpImpl{
-    public:
-    
-        Ipv6Impl() : Ipv6Impl(createLocalhost(), 0 , 0) { } //default constructor, creates localhost with no fancy stuff
-        
-        Ipv6Impl(addrinfo* info) noexcept : Ipv6Impl(reinterpret_cast<sockaddr_in6*>(info->ai_addr)) { }
-        
-        Ipv6Impl(const sockaddr_in6* ipv6Sockaddr) noexcept : 
-           Ipv6Impl(ipv6Sockaddr->sin6_addr, ipv6Sockaddr->sin6_flowinfo, ipv6Sockaddr->sin6_scope_id) { }
-            
-        Ipv6Impl(const in6_addr& ipv6Address, u_int32_t flow, u_int32_t scope) noexcept : IpImpl(IpVersion::IPV6), //call base constructor (bind the first argument by reference to save a copy)
-            //copy addr, flow label and scope id all is needed to create an ipv6 header (we want to be as general as possible, and these fields are ip -not tcp- specific)
-            ipv6Addr(ipv6Address), flowInfo(flow), scopeId(scope) { }
-            
-        
-        virtual ~Ipv6Impl() override= default; //just keep the old implementation
-    
-        virtual std::string getIpString() const override {
-            char ipv6String[INET6_ADDRSTRLEN]; //allocate the space to hold the ip string
-            inet_ntop(AF_INET6, &(this->ipv6Addr), ipv6String, INET6_ADDRSTRLEN);
-            return std::string(ipv6String); //return the ipv6 string (trigger ROV optim)
-        }    
-        
-        virtual sockaddr_storage getSockaddrStorage(TcpPort tcpPort) const override{
-            sockaddr_storage storage{}; //create an empty stack object (initialize to null)
-            storage.ss_family = AF_INET6; //fill in the address family
-            sockaddr_in6* ipv6Ptr = reinterpret_cast<sockaddr_in6*>(&storage); //use semantic sledgehammer to fill in the fields
-            //fill in the fields (a lot for ipv6)
-            ipv6Ptr->sin6_port = tcpPort.toNetworkByteOrder(); //do not forget to do this... otherwise your call is GARBAGE
-            ipv6Ptr->sin6_flowinfo = flowInfo;
-            ipv6Ptr->sin6_addr = ipv6Addr;
-            ipv6Ptr->sin6_scope_id = scopeId;
-            
-            return storage; //return the filled in sockaddr storage
-        }
-        
-        virtual std::unique_ptr<IpImpl> copy() const override{
-            //we will construct an identical object on the heap
-            return std::make_unique<Ipv6Impl>(ipv6Addr, flowInfo, scopeId);
-        }
-        
-    private:
-        
-        in6_addr createLocalhost(){
-            in6_addr localhostAddr{};
-            inet_pton(AF_INET6, "::1", &localhostAddr);
-            return localhostAddr; //do not move RVO is triggered
-        }
-        
-        in6_addr ipv6Addr; //struct holding the ipv6 address
-        u_int32_t flowInfo; //used to hold the flow info of ipv6
-        u_int32_t scopeId; //used to hold the scope id of ipv6
-    };
-    
-    class IpAddress::Ipv4Impl : public IpAddress::IpImpl{
-    public:
-        Ipv4Impl() noexcept : Ipv4Impl(createLocalhost()) {  } //default is localhost
-        
-        //constructor for an ipv4 addr out of an addrinfo
-        Ipv4Impl(addrinfo* info) noexcept : Ipv4Impl(reinterpret_cast<sockaddr_in*>(info->ai_addr)) { }
-        //constructor for an ipv4 out of an sockaddr_in
-        
-        Ipv4Impl(const sockaddr_in* ipv4Sockaddr) noexcept:
-            Ipv4Impl(ipv4Sockaddr->sin_addr) { } //copy the address (default copy constructor)
-            
-        //base constructor, used for constructing a new ipv4 address, all the other constructors lead to this one
-        Ipv4Impl(const in_addr& ipv4Address) noexcept : 
-            IpImpl(IpVersion::IPV4), //instantiate the base class
-            ipv4Addr(ipv4Address) { }
-        
-        virtual ~Ipv4Impl() override = default;
-
-        
-        virtual std::string getIpString() const override {
-            char ipv4String[INET_ADDRSTRLEN];
-            inet_ntop(AF_INET, &(this->ipv4Addr), ipv4String, INET_ADDRSTRLEN);
-            return std::string(ipv4String);
-        }
-        
-        virtual sockaddr_storage getSockaddrStorage(TcpPort tcpPort) const override{
-            sockaddr_storage storage{}; //create empty sockaddr storage
-            storage.ss_family = AF_INET;
-            sockaddr_in* ipv4Ptr = reinterpret_cast<sockaddr_in*>(&storage); //use semantic sledgehammer to fill in the fields
-            //fill in the fields
-            ipv4Ptr->sin_port = tcpPort.toNetworkByteOrder();//convert to network byte order, otherwise GARBAGE results
-            ipv4Ptr->sin_addr = ipv4Addr;
-            //return the filled in sockaddr storage
-            return storage;
-        }
-        
-        virtual std::unique_ptr<IpImpl> copy() const override{
-            //create an identical copy by invoking the constructor with the same parameters
-            return std::make_unique<Ipv4Impl>(ipv4Addr);
-        }
-        
-    private:
-        static in_addr createLocalhost() noexcept {
-            in_addr localhostAddr{};
-            inet_pton(AF_INET, "127.0.0.1", &localhostAddr);
-            return localhostAddr; //do not move, RVO is triggered
-        }
-    
-        in_addr ipv4Addr; //struct holding the ipv4 address
-    };
+    static in_addr createIpv4Localhost() noexcept {
+        in_addr localhostAddr{};
+        inet_pton(AF_INET, "127.0.0.1", &localhostAddr);
+        return localhostAddr; //do not move, RVO is triggered
+    }
     
     IpAddress::IpAddress(const char* hostname) : IpAddress(std::string(hostname)) { }
     
-    IpAddress::IpAddress(const std::string& hostname) : IpAddress(std::move(makeIpImpl(hostname))) { }; 
+    IpAddress::IpAddress(const std::string& hostname) : IpAddress(Resolver::getDefault().resolveFirst(hostname)) { } //cached lookup
     
-    std::unique_ptr<IpAddress::IpImpl> IpAddress::makeIpImpl(const std::string& hostname){
+    IpAddress::AddrinfoHandle IpAddress::lookupHost(const std::string& hostname){
         //create the hints to find the ip address
         addrinfo hints{}; //empty init
         addrinfo* searchResult;//pointer for the search results
@@ -157,81 +41,57 @@ namespace snl{
             throw SnlException(std::string("IpAddress error: ") + std::string(gai_strerror(status)));
         }
         
-        std::unique_ptr<addrinfo, void (*)(addrinfo*)> info(searchResult, freeaddrinfo); //custom deleter to make shure the addrinfo gets freed
-
-        
-        //then create an ip impl obj depending on the address family
-        switch(searchResult->ai_family){
-            case AF_INET:
-                return std::unique_ptr<IpImpl>(new Ipv4Impl(info.get())); //safe to use handle, constructor is noexcept
-            case AF_INET6:
-                return std::unique_ptr<IpImpl>(new Ipv6Impl(info.get())); //safe to use handle, constructor is noexcept
-            default:
-                throw SnlException("IpAddress error: unknown address family");
-        }
-        
-        //the resources will be freed automatically after finishing the construction
+        return AddrinfoHandle(searchResult, freeaddrinfo); //custom deleter to make shure the addrinfo gets freed
     }
     
-     std::unique_ptr<IpAddress::IpImpl> IpAddress::makeIpImpl(const sockaddr_storage& storage){
-        switch(storage.ss_family){
+    IpAddress::IpAddress(const sockaddr* address) {
+        std::memset(&raw, 0, sizeof(raw)); //the whole union is zeroed, raw addresses are compared byte wise
+        switch(address->sa_family){
             case AF_INET:
-                return std::make_unique<Ipv4Impl>(reinterpret_cast<const sockaddr_in*>(&storage)); //call the constructor with sockaddr in
-            case AF_INET6:
-                return std::make_unique<Ipv6Impl>(reinterpret_cast<const sockaddr_in6*>(&storage)); //call the concstructor with sockaddr in6
+                raw.ipv4.sin_family = AF_INET;
+                raw.ipv4.sin_addr = reinterpret_cast<const sockaddr_in*>(address)->sin_addr;
+                break;
+            case AF_INET6:{
+                const sockaddr_in6* ipv6Sockaddr = reinterpret_cast<const sockaddr_in6*>(address);
+                //the flow label and scope id are kept, they are ip -not tcp- specific
+                raw.ipv6.sin6_family = AF_INET6;
+                raw.ipv6.sin6_flowinfo = ipv6Sockaddr->sin6_flowinfo;
+                raw.ipv6.sin6_addr = ipv6Sockaddr->sin6_addr;
+                raw.ipv6.sin6_scope_id = ipv6Sockaddr->sin6_scope_id;
+                break; }
             default:
                 throw SnlException("IpAddress error: unknown address family");
         }
-        
-    }
-    
-    
-    IpAddress::IpAddress() : IpAddress(std::move(std::make_unique<Ipv4Impl>())) { } //default constructor uses the default constructor of ipv4 addresses
-    
-    IpAddress::IpAddress(std::unique_ptr<IpImpl> ipPtr) : ipImplPtr(std::move(ipPtr)) { }
-    
-    IpAddress::IpAddress(const IpAddress& rhs) : ipImplPtr(rhs.ipImplPtr->copy()) { }
-    
-    IpAddress::IpAddress(IpAddress&& rhs) noexcept : ipImplPtr(std::move(rhs.ipImplPtr)){ }
-    
-    IpAddress& IpAddress::operator =(const IpAddress& rhs){
-        IpAddress temp = rhs; //make a copy
-        //swap the contents of the copy with this -> guard against self reference (case this & other are the same)
-        using std::swap;
-        swap(*this, temp); 
-        return *this;
     }
     
-    IpAddress& IpAddress::operator =(IpAddress&& rhs) noexcept {
-        assert(this != &rhs);
-        this->ipImplPtr = std::move(rhs.ipImplPtr);
-        return *this;
+    IpAddress::IpAddress() { //default is the ipv4 localhost
+        std::memset(&raw, 0, sizeof(raw));
+        raw.ipv4.sin_family = AF_INET;
+        raw.ipv4.sin_addr = createIpv4Localhost();
     }
     
-    IpAddress::~IpAddress(){ }
-
    /*
     * general functionality
     */ 
     
     std::string IpAddress::getIpString() const {
-        return ipImplPtr->getIpString();
-    }
-    
-    bool IpAddress::isIpv4() const{
-        return ipImplPtr->getIpVersion() == IpVersion::IPV4;
+        char ipString[INET6_ADDRSTRLEN]; //large enough for both families
+        if(isIpv4()){
+            inet_ntop(AF_INET, &raw.ipv4.sin_addr, ipString, INET6_ADDRSTRLEN);
+        }else{
+            inet_ntop(AF_INET6, &raw.ipv6.sin6_addr, ipString, INET6_ADDRSTRLEN);
+        }
+        return std::string(ipString);
     }
     
-    bool IpAddress::isIpv6() const{
-        return ipImplPtr->getIpVersion() == IpVersion::IPV6;
+    bool IpAddress::isIpv4() const noexcept{
+        return raw.ipv4.sin_family == static_cast<sa_family_t>(IpVersion::IPV4);
     }
     
-    sockaddr_storage IpAddress::makeSockaddrStorage(TcpPort tcpPort){
-        return ipImplPtr->getSockaddrStorage(tcpPort);
+    bool IpAddress::isIpv6() const noexcept{
+        return raw.ipv4.sin_family == static_cast<sa_family_t>(IpVersion::IPV6);
     }
     
-   
-    
    /*
     * implementation of friend functions
     */
@@ -243,9 +103,10 @@ namespace snl{
             throw SnlException("IpAddress error: malformed ipv4 address supplied to ipv4 string");
         }
         
-        //create an unique ptr to ipv4impl and store it inside a base impl pointer
-        std::unique_ptr<IpAddress::IpImpl> implPtr = std::make_unique<IpAddress::Ipv4Impl>(std::move(ipv4Addr));
-        return IpAddress(std::move(implPtr)); //return the ip addr created by the private constructor
+        sockaddr_in ipv4Sockaddr{};
+        ipv4Sockaddr.sin_family = AF_INET;
+        ipv4Sockaddr.sin_addr = ipv4Addr;
+        return IpAddress(reinterpret_cast<const sockaddr*>(&ipv4Sockaddr)); //return the ip addr created by the private constructor
     }
     
     IpAddress makeIpv6Address(const std::string& ipv6String, u_int32_t flowInfo, u_int32_t scopeId){
@@ -255,20 +116,68 @@ namespace snl{
             throw SnlException("IpAddress error: malformed ipv6 address supplied to ipv6 string");
         }
         
-        //create an unique ptr to ipv6 impl and store it inside a base impl pointer
-        std::unique_ptr<IpAddress::IpImpl> implPtr = std::make_unique<IpAddress::Ipv6Impl>(ipv6Addr, flowInfo, scopeId);
-        return IpAddress(std::move(implPtr)); //return the ip addr created by the private constructor
+        sockaddr_in6 ipv6Sockaddr{};
+        ipv6Sockaddr.sin6_family = AF_INET6;
+        ipv6Sockaddr.sin6_flowinfo = flowInfo;
+        ipv6Sockaddr.sin6_addr = ipv6Addr;
+        ipv6Sockaddr.sin6_scope_id = scopeId;
+        return IpAddress(reinterpret_cast<const sockaddr*>(&ipv6Sockaddr)); //return the ip addr created by the private constructor
     }
     
     IpAddress makeIpAddress(const sockaddr_storage& storage){
-        return IpAddress(std::move(IpAddress::makeIpImpl(storage)));
+        return IpAddress(reinterpret_cast<const sockaddr*>(&storage));
+    }
+    
+    std::vector<IpAddress> resolveAll(const std::string& hostname){
+        IpAddress::AddrinfoHandle info = IpAddress::lookupHost(hostname);
+        
+        //split per family, keeping the order of the resolver (it is sorted by preference)
+        std::vector<IpAddress> ipv6Addresses;
+        std::vector<IpAddress> ipv4Addresses;
+        int preferredFamily = info->ai_family;
+        for(addrinfo* entry = info.get(); entry != nullptr; entry = entry->ai_next){
+            std::vector<IpAddress>* family = nullptr;
+            if(entry->ai_family == AF_INET6){
+                family = &ipv6Addresses;
+            }else if(entry->ai_family == AF_INET){
+                family = &ipv4Addresses;
+            }else{
+                continue; //unknown family, skip it
+            }
+            
+            IpAddress address(entry->ai_addr);
+            //the resolver can report the same address more than once (e.g. /etc/hosts and dns)
+            bool duplicate = false;
+            for(const IpAddress& known : *family){
+                duplicate = duplicate || std::memcmp(&known.raw, &address.raw, sizeof(address.raw)) == 0;
+            }
+            if(!duplicate){
+                family->push_back(std::move(address));
+            }
+        }
+        
+        //interleave the families, starting with the preferred one
+        std::vector<IpAddress>& first = preferredFamily == AF_INET ? ipv4Addresses : ipv6Addresses;
+        std::vector<IpAddress>& second = preferredFamily == AF_INET ? ipv6Addresses : ipv4Addresses;
+        std::vector<IpAddress> addresses;
+        addresses.reserve(first.size() + second.size());
+        for(std::size_t i = 0; i < first.size() || i < second.size(); i++){
+            if(i < first.size()){
+                addresses.push_back(std::move(first[i]));
+            }
+            if(i < second.size()){
+                addresses.push_back(std::move(second[i]));
+            }
+        }
+        
+        return addresses;
     }
     
     void swap(IpAddress& lhs, IpAddress& rhs){
-        //we only need to swap in implementation pointers
-        using std::swap;
-        //swap the two implementation pointers
-        (lhs.ipImplPtr).swap(rhs.ipImplPtr);
+        //a plain value, swapping is three copies
+        IpAddress temp = lhs;
+        lhs = rhs;
+        rhs = temp;
     }
     
 }
@@ -3,18 +3,28 @@
 
 //cpp headers
 #include <memory>
+#include <string>
+#include <vector>
 //c headers
+#include <netinet/in.h>
+#include <sys/types.h>
 
 //own headers
 
 //forward declarations
 struct sockaddr_storage;
+struct addrinfo;
 
 namespace snl{
     
     //forward declarations
     class TcpPort;
     
+    /**
+     * Ip address (v4 or v6) stored inline as a raw sockaddr
+     * the address is a trivially copyable value: copying it is a copy of a few bytes, no allocation and
+     * no virtual calls, and building the sockaddr for a connect or bind is a copy as well.
+     */
     class IpAddress{
     public:
     
@@ -24,48 +34,43 @@ namespace snl{
         friend IpAddress makeIpv4Address(const std::string& ipv4String); //directly converts the address (faster than hostname)
         friend IpAddress makeIpv6Address(const std::string& ipv6String, u_int32_t flowInfo, u_int32_t scopeId); //directly converts the address (faster than hostname)
         friend IpAddress makeIpAddress(const sockaddr_storage& storage); // extracts the ip address out of the sockaddr storage
-        friend void swap(IpAddress& lhs, IpAddress& rhs);
+        friend std::vector<IpAddress> resolveAll(const std::string& hostname); //keeps every address the hostname resolves to
         IpAddress();
         
         IpAddress(const std::string& hostname);
         IpAddress(const char* hostname);
         
-        IpAddress(const IpAddress& rhs);
-        IpAddress(IpAddress&& rhs) noexcept;
+        IpAddress(const IpAddress& rhs) noexcept = default;
+        IpAddress(IpAddress&& rhs) noexcept = default;
         
-        IpAddress& operator=(const IpAddress& rhs);
-        IpAddress& operator=(IpAddress&& rhs) noexcept;
+        IpAddress& operator=(const IpAddress& rhs) noexcept = default;
+        IpAddress& operator=(IpAddress&& rhs) noexcept = default;
         
-        ~IpAddress();
+        ~IpAddress() = default;
         
         std::string getIpString() const;
         
-        bool isIpv4() const;
+        bool isIpv4() const noexcept;
         
-        bool isIpv6() const;
+        bool isIpv6() const noexcept;
         
     private:
-            
-        //declare the implementation class
-        class IpImpl; //base class
-        class Ipv6Impl; // specialization for ipv6
-        class Ipv4Impl; // specialization for ipv4
     
-        //creates a sockaddr storage object from the curren ip address
-        //can be used by socketAddress to create a new socket
-        sockaddr_storage makeSockaddrStorage(TcpPort tcpPort);
-        
-        //factory function for an IpImpl object provided the hostname
-        static std::unique_ptr<IpImpl> makeIpImpl(const std::string& hostname);
+        //the raw address, the family field tells which member is used (the port is always 0)
+        union RawAddress{
+            sockaddr_in ipv4;
+            sockaddr_in6 ipv6;
+        };
         
-        //factory function for an IpImpl object provided the sockaddr storage
-        static std::unique_ptr<IpImpl> makeIpImpl(const sockaddr_storage& storage);
+        //runs getaddrinfo for the hostname, the result list is freed by the returned handle
+        using AddrinfoHandle = std::unique_ptr<addrinfo, void (*)(addrinfo*)>;
+        static AddrinfoHandle lookupHost(const std::string& hostname);
         
-        //private constructor to create an ip address from an unique ptr to impl
-        IpAddress(std::unique_ptr<IpImpl> ipPtr);
+        //private constructor to create an ip address from a raw sockaddr (the port is dropped)
+        //throws if the family is not AF_INET or AF_INET6
+        explicit IpAddress(const sockaddr* address);
         
-        //declare the unique pointer
-        std::unique_ptr<IpImpl> ipImplPtr;
+        RawAddress raw;
 
     };
     
@@ -92,6 +97,15 @@ namespace snl{
      */
     IpAddress makeIpAddress(const sockaddr_storage& storage);
     
+    /**
+     * @brief resolves the hostname to all of its addresses (A and AAAA records)
+     * @param hostname the hostname (or ip string) to resolve
+     * @return the distinct addresses, the families are interleaved starting with the preferred family
+     *         of the system (RFC 8305 ordering, ready for a happy eyeballs connect)
+     * @throws SnlException if the hostname can not be resolved
+     */
+    std::vector<IpAddress> resolveAll(const std::string& hostname);
+    
     /**
      * @brief swaps the contents of the lhs and the rhs
      * @param lhs the left hand side variable to swap
@@ -0,0 +1,92 @@
+#include "ListenerGroup.h"
+//c headers
+//cpp headers
+#include <string>
+//own headers
+#include "SocketAddress.h"
+#include "StreamSocket.h"
+#include "SnlException.h"
+
+namespace snl{
+
+    ListenerGroup::ListenerGroup(const SocketAddress& sockAddr, std::size_t shards, Mode mode_, int backlog) :
+        mode(mode_), shardCount(shards), acceptCounts(shards){
+        if(shards == 0){
+            throw SnlException("ListenerGroup error: a group needs at least one shard");
+        }
+
+        std::size_t nbServers = mode == Mode::REUSEPORT ? shards : 1;
+        servers.reserve(nbServers);
+
+        SocketAddress groupAddr = sockAddr;
+        for(std::size_t i = 0; i != nbServers; i++){
+            ServerSocket servSock;
+            servSock.setReusePort(mode == Mode::REUSEPORT);
+            //the shared socket is used by several workers at once, none of them may block on it
+            servSock.setNonBlockIO(mode == Mode::EXCLUSIVE);
+            servSock.bind(groupAddr);
+            servSock.listen(backlog);
+            //with port 0 the first bind picks the port, the other shards must use the same one
+            groupAddr = servSock.getSockAddr();
+            servers.push_back(std::move(servSock));
+        }
+    }
+
+    ListenerGroup::~ListenerGroup() = default; //the server sockets close themselves
+
+    ServerSocket& ListenerGroup::getShard(std::size_t shard){
+        return shardSocket(shard);
+    }
+
+    std::size_t ListenerGroup::acceptBatch(std::size_t shard, std::vector<StreamSocket>& sockets, std::size_t maxAccepts){
+        std::size_t accepted = shardSocket(shard).acceptBatch(sockets, maxAccepts);
+        acceptCounts[shard].fetch_add(accepted, std::memory_order_relaxed);
+        return accepted;
+    }
+
+    void ListenerGroup::attach(std::size_t shard, EventLoop& loop, EventLoop::AcceptCallback onAccept){
+        ServerSocket& servSock = shardSocket(shard);
+        std::atomic<std::size_t>& counter = acceptCounts[shard];
+        auto countingAccept = [&counter, onAccept = std::move(onAccept)](EventLoop& acceptLoop, StreamSocket&& strSock){
+            counter.fetch_add(1, std::memory_order_relaxed);
+            onAccept(acceptLoop, std::move(strSock));
+        };
+        loop.addServer(servSock, std::move(countingAccept), mode == Mode::EXCLUSIVE);
+    }
+
+    std::vector<std::size_t> ListenerGroup::getAcceptCounts() const{
+        std::vector<std::size_t> counts;
+        counts.reserve(acceptCounts.size());
+        for(const auto& counter : acceptCounts){
+            counts.push_back(counter.load(std::memory_order_relaxed));
+        }
+        return counts;
+    }
+
+    std::size_t ListenerGroup::getShardCount() const noexcept{
+        return shardCount;
+    }
+
+    ListenerGroup::Mode ListenerGroup::getMode() const noexcept{
+        return mode;
+    }
+
+    SocketAddress ListenerGroup::getSockAddr(){
+        return servers.front().getSockAddr();
+    }
+
+    void ListenerGroup::close(){
+        for(ServerSocket& servSock : servers){
+            if(!servSock.isClosed()){
+                servSock.close();
+            }
+        }
+    }
+
+    ServerSocket& ListenerGroup::shardSocket(std::size_t shard){
+        if(shard >= shardCount){
+            throw SnlException("ListenerGroup error: shard " + std::to_string(shard) + " does not exist");
+        }
+        return mode == Mode::REUSEPORT ? servers[shard] : servers.front();
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef LISTENERGROUP_H
+#define LISTENERGROUP_H
+//c headers
+//cpp headers
+#include <atomic>
+#include <cstdint>
+#include <vector>
+//own headers
+#include "EventLoop.h"
+#include "ServerSocket.h"
+
+namespace snl{
+
+    //forward declarations
+    class SocketAddress;
+
+    /**
+     * A group of listening sockets on one address, one shard per worker thread
+     * REUSEPORT: every shard has its own server socket bound with SO_REUSEPORT, the kernel spreads
+     *            the incoming connections over the sockets
+     * EXCLUSIVE: all shards share a single (non blocking) server socket, every worker registers it
+     *            with EPOLLEXCLUSIVE so a connection only wakes up one of them
+     * The group counts the accepts per shard so an imbalance between the workers is visible.
+     */
+    class ListenerGroup
+    {
+    public:
+
+        enum class Mode:uint8_t {REUSEPORT = 0, EXCLUSIVE = 1};
+
+        /**
+         * @brief creates the listening sockets of the group
+         * @param sockAddr the address to listen on, if the port is 0 all the shards share the port picked for the first one
+         * @param shards the number of shards (worker threads)
+         * @param mode the way the shards share the address
+         * @param backlog the listen backlog of every server socket
+         * @throws SnlException if a socket could not be bound or shards is 0
+         */
+        ListenerGroup(const SocketAddress& sockAddr, std::size_t shards, Mode mode = Mode::REUSEPORT, int backlog = defaultBacklog);
+        ~ListenerGroup();
+
+        ListenerGroup(const ListenerGroup& rhs) = delete;
+        ListenerGroup& operator=(const ListenerGroup& rhs) = delete;
+
+        /**
+         * @brief getter for the server socket a shard accepts on
+         * note: in exclusive mode all the shards return the same socket
+         */
+        ServerSocket& getShard(std::size_t shard);
+
+        /**
+         * @brief accepts the waiting clients on the socket of the shard (see ServerSocket::acceptBatch)
+         * @return the number of sockets appended
+         */
+        std::size_t acceptBatch(std::size_t shard, std::vector<StreamSocket>& sockets, std::size_t maxAccepts = defaultAcceptBatch);
+
+        /**
+         * @brief registers the socket of the shard with the event loop of its worker
+         * @param shard the shard that belongs to the worker running the loop
+         * @param loop the event loop of the worker
+         * @param onAccept the callback that receives the connections accepted by the shard
+         */
+        void attach(std::size_t shard, EventLoop& loop, EventLoop::AcceptCallback onAccept);
+
+        /**
+         * @brief getter for the number of connections accepted per shard
+         * @return a snapshot of the counters, indexed by shard
+         */
+        std::vector<std::size_t> getAcceptCounts() const;
+
+        std::size_t getShardCount() const noexcept;
+        Mode getMode() const noexcept;
+        SocketAddress getSockAddr();
+
+        /**
+         * @brief closes all the server sockets of the group
+         */
+        void close();
+
+        static constexpr int defaultBacklog = 128;
+        static constexpr std::size_t defaultAcceptBatch = 1024;
+
+    private:
+
+        //checks if the shard exists and returns the socket it accepts on
+        ServerSocket& shardSocket(std::size_t shard);
+
+        Mode mode;
+        std::size_t shardCount;
+        std::vector<ServerSocket> servers; //one per shard, or a single shared one in exclusive mode
+        std::vector<std::atomic<std::size_t>> acceptCounts;
+    };
+}
+
+#endif // LISTENERGROUP_H
@@ -0,0 +1,125 @@
+#include "MirroredRingBuffer.h"
+//c headers
+#include <cerrno>
+#include <sys/mman.h>
+#include <unistd.h>
+//cpp headers
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+//own headers
+#include "FdGuard.h"
+#include "SnlException.h"
+#include "StreamSocket.h"
+
+namespace snl{
+
+    MirroredRingBuffer::MirroredRingBuffer(std::size_t minCapacity){
+        std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        //the rounded capacity is mapped twice
+        if(minCapacity > SIZE_MAX / 2 - pageSize){
+            throw SnlException("MirroredRingBuffer error: ", ENOMEM);
+        }
+        capacity = (std::max<std::size_t>(minCapacity, 1) + pageSize - 1) / pageSize * pageSize;
+
+        //the memory lives in an anonymous file so it can be mapped twice
+        FdGuard memGuard = makeFdGuard(::memfd_create, "snl-ring", MFD_CLOEXEC);
+        executeSyscall(::ftruncate, -1, memGuard.get(), static_cast<off_t>(capacity));
+
+        //reserve the address range of both halves first, so nothing else can be mapped in between
+        void* reserved = ::mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(reserved == MAP_FAILED){
+            throw SnlException("MirroredRingBuffer error: ", errno);
+        }
+        char* base = static_cast<char*>(reserved);
+        for(char* half : {base, base + capacity}){
+            if(::mmap(half, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memGuard.get(), 0) == MAP_FAILED){
+                int errorNo = errno;
+                ::munmap(base, 2 * capacity);
+                throw SnlException("MirroredRingBuffer error: ", errorNo);
+            }
+        }
+        data = base;
+        //the mappings keep the memory alive, the file descriptor is closed by the guard
+    }
+
+    MirroredRingBuffer::MirroredRingBuffer(MirroredRingBuffer&& rhs) noexcept :
+        data(std::exchange(rhs.data, nullptr)), capacity(std::exchange(rhs.capacity, 0)),
+        head(std::exchange(rhs.head, 0)), size(std::exchange(rhs.size, 0)) { }
+
+    MirroredRingBuffer& MirroredRingBuffer::operator=(MirroredRingBuffer&& rhs) noexcept{
+        if(this != &rhs){
+            unmap();
+            data = std::exchange(rhs.data, nullptr);
+            capacity = std::exchange(rhs.capacity, 0);
+            head = std::exchange(rhs.head, 0);
+            size = std::exchange(rhs.size, 0);
+        }
+        return *this;
+    }
+
+    MirroredRingBuffer::~MirroredRingBuffer(){
+        unmap();
+    }
+
+    std::string_view MirroredRingBuffer::getReadable() const noexcept{
+        return std::string_view(data + head, size);
+    }
+
+    std::span<char> MirroredRingBuffer::getWritable() noexcept{
+        //head + size never exceeds twice the capacity, the mirror makes the wrap invisible
+        return std::span<char>(data + head + size, capacity - size);
+    }
+
+    void MirroredRingBuffer::commit(std::size_t byteCount) noexcept{
+        size += std::min(byteCount, capacity - size);
+    }
+
+    void MirroredRingBuffer::consume(std::size_t byteCount) noexcept{
+        byteCount = std::min(byteCount, size);
+        size -= byteCount;
+        head = size == 0 ? 0 : (head + byteCount) % capacity;
+    }
+
+    void MirroredRingBuffer::clear() noexcept{
+        head = 0;
+        size = 0;
+    }
+
+    std::size_t MirroredRingBuffer::getCapacity() const noexcept{
+        return capacity;
+    }
+
+    std::size_t MirroredRingBuffer::getReadableSize() const noexcept{
+        return size;
+    }
+
+    std::size_t MirroredRingBuffer::getWritableSize() const noexcept{
+        return capacity - size;
+    }
+
+    bool MirroredRingBuffer::isEmpty() const noexcept{
+        return size == 0;
+    }
+
+    bool MirroredRingBuffer::isFull() const noexcept{
+        return size == capacity;
+    }
+
+    void MirroredRingBuffer::unmap() noexcept{
+        if(data != nullptr){
+            ::munmap(data, 2 * capacity);
+            data = nullptr;
+        }
+    }
+
+    std::size_t receiveRing(StreamSocket& strSock, MirroredRingBuffer& ring, int flags){
+        std::span<char> writable = ring.getWritable();
+        if(writable.empty()){
+            return 0; //a receive of 0 bytes would block or be taken for the end of the stream
+        }
+        std::size_t bytesReceived = strSock.receive(writable.data(), writable.size(), flags);
+        ring.commit(bytesReceived);
+        return bytesReceived;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef MIRROREDRINGBUFFER_H
+#define MIRROREDRINGBUFFER_H
+//c headers
+//cpp headers
+#include <span>
+#include <string_view>
+//own headers
+
+namespace snl{
+
+    //forward declarations
+    class StreamSocket;
+
+    /**
+     * Ring buffer whose memory is mapped twice back to back
+     * the byte after the end of the ring is the first byte of the ring again, so both the unread data and the
+     * free space are always a single contiguous region, even when they wrap around the end.
+     * Records can be parsed in place and the socket receives straight into the free space: no compaction moves,
+     * no copies.
+     * note: the capacity is rounded up to a multiple of the page size
+     */
+    class MirroredRingBuffer
+    {
+    public:
+
+        static constexpr std::size_t defaultCapacity = 64 * 1024;
+
+        explicit MirroredRingBuffer(std::size_t minCapacity = defaultCapacity);
+        MirroredRingBuffer(MirroredRingBuffer&& rhs) noexcept;
+        MirroredRingBuffer& operator=(MirroredRingBuffer&& rhs) noexcept;
+        ~MirroredRingBuffer();
+
+        MirroredRingBuffer(const MirroredRingBuffer& rhs) = delete;
+        MirroredRingBuffer& operator=(const MirroredRingBuffer& rhs) = delete;
+
+        /**
+         * @brief the unread data as one contiguous view (valid until the data is consumed)
+         */
+        std::string_view getReadable() const noexcept;
+
+        /**
+         * @brief the free space as one contiguous region, call commit with the bytes written into it
+         */
+        std::span<char> getWritable() noexcept;
+
+        /**
+         * @brief makes byteCount bytes written into the free space readable
+         */
+        void commit(std::size_t byteCount) noexcept;
+
+        /**
+         * @brief drops byteCount bytes from the front of the unread data
+         */
+        void consume(std::size_t byteCount) noexcept;
+
+        void clear() noexcept;
+
+        std::size_t getCapacity() const noexcept;
+        std::size_t getReadableSize() const noexcept;
+        std::size_t getWritableSize() const noexcept;
+        bool isEmpty() const noexcept;
+        bool isFull() const noexcept;
+
+    private:
+
+        void unmap() noexcept;
+
+        char* data = nullptr; //start of the first mapping, the second one follows at data + capacity
+        std::size_t capacity = 0;
+        std::size_t head = 0; //offset of the first unread byte, always below the capacity
+        std::size_t size = 0; //number of unread bytes
+    };
+
+    /**
+     * @brief receives once straight into the free space of the ring
+     * @return the number of bytes received, 0 if the ring is full
+     * note: blocks like StreamSocket::receive, throws an SnlEofException at the end of the stream
+     */
+    std::size_t receiveRing(StreamSocket& strSock, MirroredRingBuffer& ring, int flags = 0);
+}
+
+#endif // MIRROREDRINGBUFFER_H
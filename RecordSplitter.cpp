@@ -0,0 +1,279 @@
+#include "RecordSplitter.h"
+//c headers
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SNL_X86_KERNELS 1
+#endif
+//cpp headers
+#include <algorithm>
+#include <bit>
+#include <utility>
+//own headers
+#include "SnlException.h"
+
+namespace snl{
+
+    namespace{
+
+        /*
+         * scalar kernels, used for the tail of the vector kernels and on other architectures
+         */
+
+        void findByteScalar(const char* data, std::size_t begin, std::size_t size, char byte, std::vector<std::size_t>& offsets){
+            const char* cursor = data + begin;
+            const char* end = data + size;
+            while(cursor != end){
+                const char* match = static_cast<const char*>(std::memchr(cursor, byte, end - cursor));
+                if(match == nullptr){
+                    return;
+                }
+                offsets.push_back(match - data);
+                cursor = match + 1;
+            }
+        }
+
+        void findPairScalar(const char* data, std::size_t begin, std::size_t size, char first, char second, std::vector<std::size_t>& offsets){
+            for(std::size_t i = begin; i + 1 < size; i++){
+                if(data[i] == first && data[i + 1] == second){
+                    offsets.push_back(i);
+                }
+            }
+        }
+
+#ifdef SNL_X86_KERNELS
+
+        //pushes the offset of every bit set in the match mask of the chunk at base
+        inline void pushMatches(std::uint32_t mask, std::size_t base, std::vector<std::size_t>& offsets){
+            while(mask != 0){
+                offsets.push_back(base + static_cast<std::size_t>(std::countr_zero(mask)));
+                mask &= mask - 1;
+            }
+        }
+
+        /*
+         * sse2 kernels, part of the x86-64 baseline
+         */
+
+        void findByteSse2(const char* data, std::size_t size, char byte, std::vector<std::size_t>& offsets){
+            const __m128i needle = _mm_set1_epi8(byte);
+            std::size_t i = 0;
+            for(; i + 16 <= size; i += 16){
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                pushMatches(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle))), i, offsets);
+            }
+            findByteScalar(data, i, size, byte, offsets);
+        }
+
+        void findPairSse2(const char* data, std::size_t size, char first, char second, std::vector<std::size_t>& offsets){
+            const __m128i firstNeedle = _mm_set1_epi8(first);
+            const __m128i secondNeedle = _mm_set1_epi8(second);
+            std::size_t i = 0;
+            //the second byte of the pair is compared on the chunk shifted by one byte
+            for(; i + 17 <= size; i += 16){
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+                __m128i matches = _mm_and_si128(_mm_cmpeq_epi8(chunk, firstNeedle), _mm_cmpeq_epi8(next, secondNeedle));
+                pushMatches(static_cast<std::uint32_t>(_mm_movemask_epi8(matches)), i, offsets);
+            }
+            findPairScalar(data, i, size, first, second, offsets);
+        }
+
+        /*
+         * avx2 kernels, only called if the cpu supports avx2
+         */
+
+        __attribute__((target("avx2")))
+        void findByteAvx2(const char* data, std::size_t size, char byte, std::vector<std::size_t>& offsets){
+            const __m256i needle = _mm256_set1_epi8(byte);
+            std::size_t i = 0;
+            for(; i + 32 <= size; i += 32){
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                pushMatches(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle))), i, offsets);
+            }
+            findByteScalar(data, i, size, byte, offsets);
+        }
+
+        __attribute__((target("avx2")))
+        void findPairAvx2(const char* data, std::size_t size, char first, char second, std::vector<std::size_t>& offsets){
+            const __m256i firstNeedle = _mm256_set1_epi8(first);
+            const __m256i secondNeedle = _mm256_set1_epi8(second);
+            std::size_t i = 0;
+            for(; i + 33 <= size; i += 32){
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+                __m256i matches = _mm256_and_si256(_mm256_cmpeq_epi8(chunk, firstNeedle), _mm256_cmpeq_epi8(next, secondNeedle));
+                pushMatches(static_cast<std::uint32_t>(_mm256_movemask_epi8(matches)), i, offsets);
+            }
+            findPairScalar(data, i, size, first, second, offsets);
+        }
+
+        bool hasAvx2(){
+            static const bool supported = __builtin_cpu_supports("avx2");
+            return supported;
+        }
+
+#endif
+    }
+
+    SearchKernel getBestSearchKernel() noexcept{
+#ifdef SNL_X86_KERNELS
+        return hasAvx2() ? SearchKernel::AVX2 : SearchKernel::SSE2;
+#else
+        return SearchKernel::SCALAR;
+#endif
+    }
+
+    std::size_t findDelimiters(std::string_view block, std::string_view delim, std::vector<std::size_t>& offsets){
+        return findDelimiters(block, delim, offsets, getBestSearchKernel());
+    }
+
+    std::size_t findDelimiters(std::string_view block, std::string_view delim, std::vector<std::size_t>& offsets, SearchKernel kernel){
+        std::size_t found = offsets.size();
+        if(delim.empty() || block.size() < delim.size()){
+            return 0;
+        }
+        kernel = std::min(kernel, getBestSearchKernel());
+
+        if(delim.size() == 1){
+            switch(kernel){
+#ifdef SNL_X86_KERNELS
+                case SearchKernel::AVX2:
+                    findByteAvx2(block.data(), block.size(), delim[0], offsets);
+                    break;
+                case SearchKernel::SSE2:
+                    findByteSse2(block.data(), block.size(), delim[0], offsets);
+                    break;
+#endif
+                default:
+                    findByteScalar(block.data(), 0, block.size(), delim[0], offsets);
+                    break;
+            }
+        }else if(delim.size() == 2){
+            switch(kernel){
+#ifdef SNL_X86_KERNELS
+                case SearchKernel::AVX2:
+                    findPairAvx2(block.data(), block.size(), delim[0], delim[1], offsets);
+                    break;
+                case SearchKernel::SSE2:
+                    findPairSse2(block.data(), block.size(), delim[0], delim[1], offsets);
+                    break;
+#endif
+                default:
+                    findPairScalar(block.data(), 0, block.size(), delim[0], delim[1], offsets);
+                    break;
+            }
+        }else{
+            for(std::size_t position = block.find(delim); position != std::string_view::npos; position = block.find(delim, position + 1)){
+                offsets.push_back(position);
+            }
+        }
+        return offsets.size() - found;
+    }
+
+    RecordSplitter::RecordSplitter(std::string delim_, std::size_t maxRecordSize_) :
+        delim(std::move(delim_)), maxRecordSize(maxRecordSize_){
+        if(delim.empty()){
+            throw SnlException("RecordSplitter error: the delimiter can not be empty");
+        }
+    }
+
+    const std::vector<std::string_view>& RecordSplitter::split(std::string_view block){
+        records.clear();
+        offsets.clear();
+        joined.clear();
+
+        std::size_t position = 0; //start of the next record in the block
+        std::size_t splitDelim = findSplitDelimiter(block);
+        if(splitDelim != 0){
+            //the pending record ends with the first part of the delimiter
+            joined.swap(pending);
+            joined.resize(joined.size() - splitDelim);
+            if(discarding){
+                joined.clear(); //the end of the oversized record
+                discarding = false;
+            }else{
+                records.push_back(joined);
+            }
+            position = delim.size() - splitDelim;
+        }
+
+        std::size_t searchStart = position;
+        findDelimiters(block.substr(searchStart), delim, offsets);
+        for(std::size_t offset : offsets){
+            std::size_t delimStart = searchStart + offset;
+            if(delimStart < position){
+                continue; //overlaps the previous delimiter
+            }
+
+            std::string_view record = block.substr(position, delimStart - position);
+            if(discarding){
+                //the end of the oversized record, the next record is a regular one again
+                pending.clear();
+                discarding = false;
+                position = delimStart + delim.size();
+                continue;
+            }
+            if(!pending.empty()){
+                //only the first record of a block can continue the pending one
+                pending.append(record);
+                joined.swap(pending);
+                pending.clear();
+                record = joined;
+            }
+            records.push_back(record);
+            position = delimStart + delim.size();
+        }
+
+        std::string_view rest = block.substr(position);
+        if(!discarding && pending.size() + rest.size() > maxRecordSize){
+            //the complete records of the block are still returned, only the oversized record is dropped
+            discarding = true;
+            oversizedRecords++;
+        }
+        pending.append(rest);
+        if(discarding){
+            //only the bytes that may start a delimiter split over the next block are kept
+            std::size_t keep = std::min(pending.size(), delim.size() - 1);
+            pending.erase(0, pending.size() - keep);
+        }
+        return records;
+    }
+
+    std::string_view RecordSplitter::getPending() const noexcept{
+        return pending;
+    }
+
+    void RecordSplitter::reset() noexcept{
+        pending.clear();
+        discarding = false;
+    }
+
+    std::size_t RecordSplitter::getOversizedRecords() const noexcept{
+        return oversizedRecords;
+    }
+
+    bool RecordSplitter::isDiscarding() const noexcept{
+        return discarding;
+    }
+
+    const std::string& RecordSplitter::getDelimiter() const noexcept{
+        return delim;
+    }
+
+    std::size_t RecordSplitter::findSplitDelimiter(std::string_view block) const noexcept{
+        std::string_view pendingView(pending);
+        std::string_view delimView(delim);
+        //longest split first, the delimiter starts as early as possible
+        for(std::size_t inPending = delim.size() - 1; inPending != 0; inPending--){
+            std::size_t inBlock = delim.size() - inPending;
+            if(pendingView.size() >= inPending && block.size() >= inBlock
+               && pendingView.substr(pendingView.size() - inPending) == delimView.substr(0, inPending)
+               && block.substr(0, inBlock) == delimView.substr(inPending)){
+                return inPending;
+            }
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef RECORDSPLITTER_H
+#define RECORDSPLITTER_H
+//c headers
+//cpp headers
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+//own headers
+
+namespace snl{
+
+    /**
+     * @brief appends the offset of every delimiter in the block to the offsets
+     * @return the number of delimiters found
+     * note: one and two byte delimiters are searched 16 (sse2) or 32 (avx2) bytes at a time,
+     *       longer delimiters use a scalar search. Matches of self overlapping delimiters may overlap.
+     */
+    std::size_t findDelimiters(std::string_view block, std::string_view delim, std::vector<std::size_t>& offsets);
+
+    //the implementations of the one and two byte delimiter search
+    enum class SearchKernel:uint8_t {SCALAR = 0, SSE2 = 1, AVX2 = 2};
+
+    /**
+     * @brief the fastest kernel the cpu supports, the one findDelimiters uses
+     */
+    SearchKernel getBestSearchKernel() noexcept;
+
+    /**
+     * @brief findDelimiters with a forced kernel, all kernels must give the same offsets (for tests and benchmarks)
+     * note: a kernel the cpu does not support falls back to the best supported one
+     */
+    std::size_t findDelimiters(std::string_view block, std::string_view delim, std::vector<std::size_t>& offsets, SearchKernel kernel);
+
+    /**
+     * Splits received blocks into delimited records in a single pass
+     * all the complete records of a block are returned at once, the incomplete record at the end of the block
+     * is kept and completed by the next block (a delimiter may also be split over two blocks).
+     * A record that grows beyond the maximum record size is dropped: the bytes up to its delimiter are
+     * discarded and the records after it are split as usual.
+     * usage:
+     *     RecordSplitter splitter;
+     *     std::size_t received = receiveBuff(strSock, block, sizeof(block));
+     *     for(std::string_view record : splitter.split(std::string_view(block, received))){ ... }
+     */
+    class RecordSplitter
+    {
+    public:
+
+        static constexpr std::size_t defaultMaxRecordSize = 1024 * 1024;
+
+        /**
+         * @param delim the record delimiter, the default matches sendline/readline
+         * @param maxRecordSize the maximum size of a record that spans blocks, longer records are discarded
+         */
+        explicit RecordSplitter(std::string delim = "\r\n", std::size_t maxRecordSize = defaultMaxRecordSize);
+
+        /**
+         * @brief splits the block into records (without the delimiters)
+         * @return the complete records, the views point into the block or the splitter
+         *         and are valid until the next call (and as long as the block is)
+         * note: the complete records of the block are always returned, an incomplete record that exceeds
+         *       the maximum record size is counted (getOversizedRecords) and discarded up to its delimiter
+         */
+        const std::vector<std::string_view>& split(std::string_view block);
+
+        /**
+         * @brief the bytes of the incomplete record carried over to the next block
+         * note: while an oversized record is discarded only its last bytes (a possible delimiter start) are kept
+         */
+        std::string_view getPending() const noexcept;
+
+        /**
+         * @brief drops the incomplete record (e.g. on a new connection)
+         */
+        void reset() noexcept;
+
+        /**
+         * @brief the number of records discarded because they exceeded the maximum record size
+         */
+        std::size_t getOversizedRecords() const noexcept;
+
+        /**
+         * @brief true while the bytes of an oversized record are discarded (until its delimiter)
+         */
+        bool isDiscarding() const noexcept;
+
+        const std::string& getDelimiter() const noexcept;
+
+    private:
+
+        //number of delimiter bytes at the end of the pending record that the block completes, 0 if none
+        std::size_t findSplitDelimiter(std::string_view block) const noexcept;
+
+        std::string delim;
+        std::size_t maxRecordSize;
+        std::string pending; //incomplete record of the previous block (only its last bytes while discarding)
+        bool discarding = false; //the pending record is oversized, it is dropped when its delimiter arrives
+        std::size_t oversizedRecords = 0;
+        std::string joined; //record completed by the current block, the records may point into it
+        std::vector<std::size_t> offsets;
+        std::vector<std::string_view> records;
+    };
+}
+
+#endif // RECORDSPLITTER_H
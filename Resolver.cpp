@@ -0,0 +1,268 @@
+#include "Resolver.h"
+//c headers
+#include <arpa/inet.h>
+//cpp headers
+//own headers
+#include "SnlException.h"
+
+namespace snl{
+
+    //converts ip literals without a lookup, returns false for anything else
+    static bool parseLiteral(const std::string& hostname, Resolver::Addresses& addresses){
+        in_addr ipv4Addr{};
+        in6_addr ipv6Addr{};
+        if(inet_pton(AF_INET, hostname.c_str(), &ipv4Addr) == 1){
+            addresses.push_back(makeIpv4Address(hostname));
+            return true;
+        }
+        if(inet_pton(AF_INET6, hostname.c_str(), &ipv6Addr) == 1){
+            addresses.push_back(makeIpv6Address(hostname));
+            return true;
+        }
+        return false;
+    }
+
+    Resolver::Resolver() : Resolver(Config()) { }
+
+    Resolver::Resolver(Config config) :
+        ttl(std::chrono::duration_cast<Clock::duration>(config.ttl).count()),
+        negativeTtl(std::chrono::duration_cast<Clock::duration>(config.negativeTtl).count()),
+        maxShardEntries(config.maxShardEntries){
+        if(config.threads == 0 || config.shards == 0 || config.maxShardEntries == 0){
+            throw SnlException("Resolver error: the resolver needs at least one thread, one shard and one entry per shard");
+        }
+
+        shards.reserve(config.shards);
+        for(std::size_t i = 0; i != config.shards; i++){
+            shards.push_back(std::make_unique<Shard>());
+        }
+        threads.reserve(config.threads);
+        for(std::size_t i = 0; i != config.threads; i++){
+            threads.emplace_back(&Resolver::work, this);
+        }
+    }
+
+    Resolver::~Resolver(){
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = true;
+        }
+        jobCondition.notify_all();
+        for(std::thread& thread : threads){
+            thread.join();
+        }
+    }
+
+    Resolver::Addresses Resolver::resolve(const std::string& hostname){
+        Addresses addresses;
+        if(parseLiteral(hostname, addresses)){
+            return addresses;
+        }
+        return resolveAsync(hostname).get();
+    }
+
+    IpAddress Resolver::resolveFirst(const std::string& hostname){
+        Addresses addresses;
+        if(parseLiteral(hostname, addresses)){
+            return std::move(addresses.front());
+        }
+        //only copy the address that is needed out of the cached list
+        std::shared_future<Addresses> result = resolveAsync(hostname);
+        const Addresses& cached = result.get();
+        if(cached.empty()){
+            throw SnlException("Resolver error: the hostname has no addresses");
+        }
+        return cached.front();
+    }
+
+    std::shared_future<Resolver::Addresses> Resolver::resolveAsync(const std::string& hostname){
+        Addresses addresses;
+        if(parseLiteral(hostname, addresses)){
+            std::promise<Addresses> promise;
+            promise.set_value(std::move(addresses));
+            return promise.get_future().share();
+        }
+
+        Shard& shard = getShard(hostname);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return findOrLookup(shard, hostname).result;
+    }
+
+    void Resolver::resolveAsync(const std::string& hostname, ResolveCallback callback){
+        Addresses addresses;
+        if(parseLiteral(hostname, addresses)){
+            callback(addresses, nullptr);
+            return;
+        }
+
+        Shard& shard = getShard(hostname);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        Entry& entry = findOrLookup(shard, hostname);
+        if(!entry.resolved){
+            entry.waiters.push_back(std::move(callback)); //called by the lookup
+            return;
+        }
+
+        //cache hit, the future is ready
+        std::shared_future<Addresses> result = entry.result;
+        lock.unlock();
+        std::exception_ptr error;
+        try{
+            result.get();
+        }catch(...){
+            error = std::current_exception();
+        }
+        //outside of the try, an exception thrown by the callback must not call it a second time
+        static const Addresses noAddresses;
+        callback(error ? noAddresses : result.get(), error);
+    }
+
+    void Resolver::prewarm(const std::vector<std::string>& hostnames){
+        for(const std::string& hostname : hostnames){
+            resolveAsync(hostname); //the future is dropped, the result stays in the cache
+        }
+    }
+
+    void Resolver::invalidate(const std::string& hostname){
+        Shard& shard = getShard(hostname);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto entryIt = shard.entries.find(hostname);
+        //a lookup in flight is kept, its waiters still need the result
+        if(entryIt != shard.entries.end() && entryIt->second.resolved){
+            shard.entries.erase(entryIt);
+        }
+    }
+
+    void Resolver::setTtl(std::chrono::seconds ttl_, std::chrono::seconds negativeTtl_) noexcept{
+        ttl = std::chrono::duration_cast<Clock::duration>(ttl_).count();
+        negativeTtl = std::chrono::duration_cast<Clock::duration>(negativeTtl_).count();
+    }
+
+    Resolver::Stats Resolver::getStats() const noexcept{
+        Stats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.coalesced = coalesced;
+        stats.evictions = evictions;
+        return stats;
+    }
+
+    Resolver& Resolver::getDefault(){
+        static Resolver defaultResolver;
+        return defaultResolver;
+    }
+
+    Resolver::Shard& Resolver::getShard(const std::string& hostname){
+        return *shards[std::hash<std::string>()(hostname) % shards.size()];
+    }
+
+    Resolver::Entry& Resolver::findOrLookup(Shard& shard, const std::string& hostname){
+        auto entryIt = shard.entries.find(hostname);
+        if(entryIt != shard.entries.end()){
+            Entry& entry = entryIt->second;
+            if(!entry.resolved){
+                coalesced++;
+                return entry;
+            }
+            if(Clock::now() < entry.expiry){
+                hits++;
+                return entry;
+            }
+            //expired, replaced by a new lookup below
+        }else if(shard.entries.size() >= maxShardEntries){
+            evict(shard);
+        }
+
+        misses++;
+        auto promise = std::make_shared<std::promise<Addresses>>();
+        Entry& entry = shard.entries[hostname];
+        entry.result = promise->get_future().share();
+        entry.resolved = false;
+        entry.waiters.clear();
+
+        post([this, &shard, hostname, promise](){ lookup(shard, hostname, promise); });
+        return entry;
+    }
+
+    void Resolver::lookup(Shard& shard, std::string hostname, std::shared_ptr<std::promise<Addresses>> promise){
+        std::exception_ptr error;
+        Clock::duration lifetime = Clock::duration(ttl.load());
+        try{
+            promise->set_value(resolveAll(hostname));
+        }catch(...){ //bad_alloc included, the entry must still be resolved for its waiters
+            error = std::current_exception();
+            promise->set_exception(error);
+            lifetime = Clock::duration(negativeTtl.load());
+        }
+
+        std::vector<ResolveCallback> waiters;
+        std::shared_future<Addresses> result;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            Entry& entry = shard.entries[hostname];
+            entry.resolved = true;
+            entry.expiry = Clock::now() + lifetime;
+            waiters.swap(entry.waiters);
+            result = entry.result;
+        }
+
+        //run the callbacks without holding the shard lock
+        static const Addresses noAddresses;
+        const Addresses& addresses = error ? noAddresses : result.get();
+        for(ResolveCallback& waiter : waiters){
+            waiter(addresses, error);
+        }
+    }
+
+    void Resolver::evict(Shard& shard){
+        //only on a miss of a full shard, the scan is cheap next to the getaddrinfo that follows
+        Clock::time_point now = Clock::now();
+        auto oldestIt = shard.entries.end();
+        for(auto entryIt = shard.entries.begin(); entryIt != shard.entries.end();){
+            Entry& entry = entryIt->second;
+            if(!entry.resolved){
+                ++entryIt; //its waiters still need the result
+                continue;
+            }
+            if(entry.expiry <= now){
+                entryIt = shard.entries.erase(entryIt);
+                evictions++;
+                continue;
+            }
+            if(oldestIt == shard.entries.end() || entry.expiry < oldestIt->second.expiry){
+                oldestIt = entryIt;
+            }
+            ++entryIt;
+        }
+
+        //nothing expired, drop the result that would expire first (a shard of lookups in flight may overflow)
+        if(shard.entries.size() >= maxShardEntries && oldestIt != shard.entries.end()){
+            shard.entries.erase(oldestIt);
+            evictions++;
+        }
+    }
+
+    void Resolver::post(std::function<void()> job){
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            jobs.push_back(std::move(job));
+        }
+        jobCondition.notify_one();
+    }
+
+    void Resolver::work(){
+        while(true){
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobCondition.wait(lock, [this](){ return stopping || !jobs.empty(); });
+                if(jobs.empty()){
+                    return; //stopping and nothing left to resolve
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+//c headers
+//cpp headers
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+//own headers
+#include "IpAddress.h"
+
+namespace snl{
+
+    /**
+     * Hostname resolver with a thread safe cache
+     * lookups run on a small background pool, concurrent lookups of the same hostname share a single
+     * getaddrinfo call (singleflight). Results are cached for the ttl, failures for the negative ttl.
+     * A full shard drops its expired results first and then the result that expires first.
+     * ip literals are converted directly and never reach the pool or the cache.
+     */
+    class Resolver
+    {
+    public:
+
+        using Addresses = std::vector<IpAddress>; //ordered as by resolveAll
+        //receives the addresses, or the error (then the addresses are empty)
+        using ResolveCallback = std::function<void(const Addresses& addresses, std::exception_ptr error)>;
+
+        struct Config{
+            std::chrono::seconds ttl{30}; //lifetime of a successful lookup
+            std::chrono::seconds negativeTtl{5}; //lifetime of a failed lookup
+            std::size_t threads = 2; //background lookup threads
+            std::size_t shards = 16; //cache shards, each with its own lock
+            std::size_t maxShardEntries = 256; //cached hostnames per shard (lookups in flight are never dropped)
+        };
+
+        struct Stats{
+            std::size_t hits = 0; //served from the cache (including cached failures)
+            std::size_t misses = 0; //started a lookup
+            std::size_t coalesced = 0; //joined a lookup in flight
+            std::size_t evictions = 0; //results dropped to make room in a full shard (expired or not)
+        };
+
+        Resolver();
+        explicit Resolver(Config config);
+        ~Resolver(); //waits for the lookups in flight
+
+        Resolver(const Resolver& rhs) = delete;
+        Resolver& operator=(const Resolver& rhs) = delete;
+
+        /**
+         * @brief resolves the hostname, blocks until the addresses are known
+         * @throws SnlException if the hostname can not be resolved
+         */
+        Addresses resolve(const std::string& hostname);
+
+        /**
+         * @brief resolves the hostname to its preferred address (what IpAddress(hostname) uses)
+         * @throws SnlException if the hostname can not be resolved
+         */
+        IpAddress resolveFirst(const std::string& hostname);
+
+        /**
+         * @brief starts resolving the hostname
+         * @return a future that becomes ready with the addresses (get() throws if the lookup failed)
+         */
+        std::shared_future<Addresses> resolveAsync(const std::string& hostname);
+
+        /**
+         * @brief resolves the hostname and hands the result to the callback
+         * note: the callback runs immediately on a cache hit, otherwise on a pool thread
+         */
+        void resolveAsync(const std::string& hostname, ResolveCallback callback);
+
+        /**
+         * @brief starts the lookups of the hostnames so later connects hit the cache
+         */
+        void prewarm(const std::vector<std::string>& hostnames);
+
+        /**
+         * @brief drops the cached result of the hostname
+         */
+        void invalidate(const std::string& hostname);
+
+        /**
+         * @brief changes the lifetime of the results cached from now on
+         */
+        void setTtl(std::chrono::seconds ttl, std::chrono::seconds negativeTtl) noexcept;
+
+        Stats getStats() const noexcept;
+
+        /**
+         * @brief the resolver used by IpAddress(hostname) and StreamSocket::connect(hostname, port)
+         */
+        static Resolver& getDefault();
+
+    private:
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry{
+            std::shared_future<Addresses> result;
+            Clock::time_point expiry;
+            bool resolved = false; //false while the lookup is in flight
+            std::vector<ResolveCallback> waiters; //callbacks of the lookup in flight
+        };
+
+        struct Shard{
+            std::mutex mutex;
+            std::unordered_map<std::string, Entry> entries;
+        };
+
+        Shard& getShard(const std::string& hostname);
+        //returns the entry of the hostname, starts a lookup if there is no fresh one (shard must be locked)
+        Entry& findOrLookup(Shard& shard, const std::string& hostname);
+        void lookup(Shard& shard, std::string hostname, std::shared_ptr<std::promise<Addresses>> promise);
+        //makes room for a new hostname in a full shard (shard must be locked)
+        void evict(Shard& shard);
+
+        //the background pool
+        void post(std::function<void()> job);
+        void work();
+
+        std::atomic<Clock::duration::rep> ttl;
+        std::atomic<Clock::duration::rep> negativeTtl;
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::size_t maxShardEntries;
+
+        std::mutex jobMutex;
+        std::condition_variable jobCondition;
+        std::deque<std::function<void()>> jobs;
+        bool stopping = false;
+        std::vector<std::thread> threads;
+
+        std::atomic<std::size_t> hits{0};
+        std::atomic<std::size_t> misses{0};
+        std::atomic<std::size_t> coalesced{0};
+        std::atomic<std::size_t> evictions{0};
+    };
+}
+
+#endif // RESOLVER_H
@@ -4,11 +4,14 @@
 //cpp headers
 #include <iostream>
 #include <cassert>
+#include <cerrno>
+#include <thread>
 //own headers
 #include "SocketAddress.h"
 #include "SnlException.h"
 #include "ServerSocketFsm.h"
 #include "StreamSocket.h"
+#include "HandlerPool.h"
 
 namespace snl{
     
@@ -50,6 +53,56 @@ namespace snl{
         return StreamSocket(std::move(guard), makeSockAddr(storage));
     }
     
+    std::size_t ServerSocket::acceptBatch(std::vector<StreamSocket>& sockets, std::size_t maxAccepts){
+        std::size_t accepted = 0;
+        bool nonBlock = fsmPtr->getNonBlockIO();
+        auto sink = [&sockets, nonBlock](FdGuard&& clientFd, const sockaddr_storage& clientSockaddr){
+            sockets.push_back(StreamSocket(std::move(clientFd), makeSockAddr(clientSockaddr), nonBlock));
+        };
+        fsmPtr->toNextState(serverAcceptBatch, sink, maxAccepts, accepted);
+        return accepted;
+    }
+    
+    void ServerSocket::serve(std::function<void(StreamSocket&)> handler, std::size_t threads){
+        HandlerPool pool(std::move(handler), threads);
+        serve(pool);
+        //the pool handles the remaining connections when it goes out of scope
+    }
+    
+    void ServerSocket::serve(HandlerPool& pool){
+        //the acceptor sleeps in accept, the accepted sockets inherit the blocking behavior for the handlers
+        setNonBlockIO(false);
+        std::vector<StreamSocket> accepted;
+        while(!fsmPtr->isDownstreamClosed()){
+            bool backOff = false;
+            try{
+                acceptBatch(accepted);
+            }catch(SnlException& e){
+                if(fsmPtr->isDownstreamClosed()){
+                    break; //woken up by closeDownstream
+                }
+                int errorNo = e.getErrorNo();
+                if(errorNo != EMFILE && errorNo != ENFILE && errorNo != ENOBUFS && errorNo != ENOMEM){
+                    throw;
+                }
+                //out of fds or memory: the clients stay in the backlog until the handlers release some
+                backOff = true;
+            }
+            
+            for(StreamSocket& strSock : accepted){
+                pool.submit(std::move(strSock));
+            }
+            accepted.clear();
+            if(backOff){
+                std::this_thread::sleep_for(acceptBackoff);
+            }
+        }
+    }
+    
+    void ServerSocket::closeDownstream(){
+        fsmPtr->toNextState(serverDownstrClose);
+    }
+    
     void ServerSocket::close(){
         fsmPtr->toNextState(serverClose);
     }
@@ -58,6 +111,22 @@ namespace snl{
         fsmPtr->toNextState(serverReset);
     }
     
+    void ServerSocket::setNonBlockIO(bool nonBlockVal){
+        fsmPtr->setNonBlockIO(nonBlockVal);
+    }
+    
+    bool ServerSocket::isNonBlock(){
+        return fsmPtr->getNonBlockIO();
+    }
+    
+    void ServerSocket::setReusePort(bool reusePortVal){
+        fsmPtr->setReusePort(reusePortVal);
+    }
+    
+    bool ServerSocket::isReusePort(){
+        return fsmPtr->getReusePort();
+    }
+    
     SocketAddress ServerSocket::getSockAddr(){
         return fsmPtr->getSockAddr();
     }
@@ -70,6 +139,10 @@ namespace snl{
         return fsmPtr->getTcpPort();
     }
     
+    int ServerSocket::getFd(){
+        return fsmPtr->getFd();
+    }
+    
     bool ServerSocket::isBound(){
         return fsmPtr->isBound();
     }
@@ -3,7 +3,10 @@
 //c headers
 
 //cpp headers
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 //own headers
 
 namespace snl{
@@ -14,6 +17,7 @@ namespace snl{
     class TcpPort;
     class ServerSocketFsm;
     class StreamSocket;
+    class HandlerPool;
     class ServerSocket{
     public:
     
@@ -38,16 +42,51 @@ namespace snl{
         
         StreamSocket accept();
         
+        /**
+         * @brief accepts all the clients that are waiting in the listen queue
+         * @param sockets the container the accepted sockets are appended to
+         * @param maxAccepts the maximum number of clients to accept in this call
+         * @return the number of sockets appended
+         * note: the accepted sockets inherit the blocking behavior of the server socket,
+         *       a non blocking server socket returns 0 if no client is waiting,
+         *       a blocking server socket blocks for the first client only
+         */
+        std::size_t acceptBatch(std::vector<StreamSocket>& sockets, std::size_t maxAccepts = defaultAcceptBatch);
+        
+        /**
+         * @brief runs the accept loop on the calling thread and hands every accepted socket to a
+         *        work stealing pool of handler threads (see HandlerPool)
+         * @param handler the function handling a connection, the socket is closed when it returns
+         * @param threads the number of handler threads
+         * note: returns after closeDownstream() is called (from another thread), the connections that
+         *       are still queued are handled before the call returns
+         */
+        void serve(std::function<void(StreamSocket&)> handler, std::size_t threads);
+        
+        /**
+         * @brief runs the accept loop on the calling thread with a pool owned by the caller
+         * note: the caller can inspect the stats of the pool while serving,
+         *       running out of fds or memory pauses accepting for acceptBackoff instead of returning
+         */
+        void serve(HandlerPool& pool);
+        
         void close();
         void closeUpstream();
-        void closeDownstream();
+        void closeDownstream(); //stops accepting new connections, wakes up a blocked accept
         
         void reset();
         
+        void setNonBlockIO(bool nonBlockVal); //sets the socket to blocking/nonblocking
+        bool isNonBlock();
+        
+        void setReusePort(bool reusePortVal); //lets several sockets bind the same address, must be called before bind
+        bool isReusePort();
+        
         //inspecting calls
         SocketAddress getSockAddr();
         IpAddress getIpAddress();
         TcpPort getTcpAddress();
+        int getFd(); //the underlying file descriptor (for event loops), -1 if there is none
         
         bool isBound();
         bool isListening();
@@ -59,6 +98,9 @@ namespace snl{
         std::unique_ptr<ServerSocketFsm> fsmPtr;
         
         static constexpr int defaultBacklog = 5;
+        static constexpr std::size_t defaultAcceptBatch = 1024;
+        //how long serve stops accepting after EMFILE/ENFILE/ENOBUFS/ENOMEM
+        static constexpr std::chrono::milliseconds acceptBackoff{100};
     }; 
 }
 
@@ -2,10 +2,13 @@
 //c headers
 #include <sys/socket.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
 
 //cpp headers
 #include <iostream>
 //own headers
+#include "BufferPool.h"
 
 //declare the used c functions to prevent name mangling in the forwarding constructor
 extern "C" {
@@ -30,17 +33,32 @@ namespace snl{
 
     ServerSocketFsm::~ServerSocketFsm(){ } //the sock fd will be automatically closed
     
+    void* ServerSocketFsm::operator new(std::size_t size){
+        std::size_t capacity = 0;
+        return BufferPool::getStatePool().allocate(size, capacity);
+    }
+    
+    void ServerSocketFsm::operator delete(void* state, std::size_t size) noexcept{
+        BufferPool& statePool = BufferPool::getStatePool();
+        statePool.deallocate(static_cast<char*>(state), statePool.getCapacity(size));
+    }
+    
     void ServerSocketFsm::toNextStateImpl(const ServerBind& , const SocketAddress& sockAddr){
 //        std::cout << "start binding" << std::endl;
         //to bind the socket address with the bind function
         bindCheck(fsmState);
         //then create the file descriptor & bind the socket (will throw if something goes wrong)
-        FdGuard guard = makeSockFdAndBind(sockAddr);
+        FdGuard guard = makeSockFdAndBind(sockAddr, reusePort);
         //check if the blocking state is as desired
         setFdBlockingBehav(guard, getNonBlockIO());
+        //if the port was left to the kernel, save the port it picked (needed to bind other sockets to the same address)
+        if(sockAddr.getTcpPort().getPortNumber() == 0){
+            this->socketAddr = getBoundSockAddr(guard);
+        }else{
+            this->socketAddr = sockAddr;
+        }
         //save the guard
         this->servSockFd = std::move(guard);
-        this->socketAddr = sockAddr;
         fsmState = ServerFsmState::BOUND;
     }
     
@@ -79,19 +97,30 @@ namespace snl{
 //    }
 //    
     //summarizing call to bind a socket to a sockaddr (can be called from both default listen and bind
-    FdGuard ServerSocketFsm::makeSockFdAndBind(const SocketAddress& sockAddr){
+    FdGuard ServerSocketFsm::makeSockFdAndBind(const SocketAddress& sockAddr, bool reusePortVal){
         //create the socket file descriptor, will throw if something went wrong
         FdGuard guard = makeFdGuard(::socket, sockAddr.getAddressFamily(), SOCK_STREAM, 0);
-        //then bind the file descriptor to the port descibed in the socket address
         int failure = -1;
-        sockaddr_storage storageSpec = sockAddr.getSockaddrStorage();
-        sockaddr* sockSpec = reinterpret_cast<sockaddr*>(&storageSpec);
+        //the reuse port option must be set before binding, all the sockets sharing the port need it
+        if(reusePortVal){
+            int enable = 1;
+            executeSyscall(::setsockopt, failure, guard.get(), SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+        }
+        //then bind the file descriptor to the port descibed in the socket address
         //will throw if something went wrong
-        executeSyscall(::bind, failure, guard.get(), sockSpec, sockAddr.getAddrlen());
+        executeSyscall(::bind, failure, guard.get(), sockAddr.getSockaddr(), sockAddr.getAddrlen());
         //then return the guard after the bind
         return guard;
     }
     
+    SocketAddress ServerSocketFsm::getBoundSockAddr(const FdGuard& guard){
+        sockaddr_storage storage{};
+        socklen_t addrlen = sizeof(sockaddr_storage);
+        int failure = -1;
+        executeSyscall(::getsockname, failure, guard.get(), reinterpret_cast<sockaddr*>(&storage), &addrlen);
+        return makeSockAddr(storage);
+    }
+    
     void ServerSocketFsm::toNextStateImpl(const ServerAccept& , FdGuard& clientFd, sockaddr_storage& clientSockaddr){
 //        std::cout << "accepting new connections" << std::endl;
         //we are accepting a new connection, the sockaddr storage passed will receive the sockaddr storage of the new connection
@@ -104,7 +133,75 @@ namespace snl{
         //the call will be succesfull(otherwise an exception would have been thrown)
         clientFd.reset(acceptedFd);
         //the clientSockaddr will also have been set so ok
-        fsmState = ServerFsmState::ACCEPTING;
+        markAccepting();
+    }
+    
+    void ServerSocketFsm::toNextStateImpl(const ServerAcceptBatch&, const AcceptSink& sink, std::size_t maxAccepts, std::size_t& accepted){
+        acceptCheck(fsmState);
+        //the accepted sockets inherit the blocking behavior of the server socket, saves a fcntl per client
+        int acceptFlags = SOCK_CLOEXEC | (nonBlockingIo ? SOCK_NONBLOCK : 0);
+        accepted = 0;
+        
+        while(accepted != maxAccepts){
+            //a blocking server socket only blocks for the first client, the rest of the batch is what is already queued
+            if(accepted != 0 && !nonBlockingIo && !hasPendingClient(servSockFd)){
+                break;
+            }
+            
+            sockaddr_storage clientSockaddr;
+            socklen_t clientAddrlen = sizeof(sockaddr_storage);
+            int acceptedFd = ::accept4(servSockFd.get(), reinterpret_cast<sockaddr*>(&clientSockaddr), &clientAddrlen, acceptFlags);
+            
+            if(acceptedFd == -1){
+                if(errno == ECONNABORTED || errno == EINTR){
+                    continue; //the client left before it was accepted, try the next one
+                }
+                if(errno == EAGAIN || errno == EWOULDBLOCK){
+                    break; //the backlog is drained
+                }
+                if(accepted == 0){
+                    throw SnlException("System call error: ", errno);
+                }
+                break; //report the clients accepted so far, the error will show up on the next call
+            }
+            
+            accepted++;
+            sink(FdGuard(acceptedFd), clientSockaddr);
+        }
+        
+        if(accepted != 0){
+            markAccepting();
+        }
+    }
+    
+    void ServerSocketFsm::markAccepting() noexcept{
+        //only a listening socket moves on (a concurrent close is not undone), after the first accept this is a
+        //plain load, the acceptors of a shared listener do not keep writing the same cache line
+        ServerFsmState expected = ServerFsmState::LISTENING;
+        if(fsmState.load(std::memory_order_relaxed) == expected){
+            fsmState.compare_exchange_strong(expected, ServerFsmState::ACCEPTING, std::memory_order_relaxed);
+        }
+    }
+    
+    bool ServerSocketFsm::hasPendingClient(const FdGuard& guard){
+        pollfd pollSpec{};
+        pollSpec.fd = guard.get();
+        pollSpec.events = POLLIN;
+        return ::poll(&pollSpec, 1, 0) == 1 && (pollSpec.revents & POLLIN);
+    }
+    
+    void ServerSocketFsm::toNextStateImpl(const ServerDClose&){
+        //no state check: this runs on another thread than the acceptor, the shutdown fails by itself
+        //if there is no socket (EBADF) or it is not listening (ENOTCONN)
+        //flag first, the acceptor checks it as soon as its accept fails
+        downstreamClosed = true;
+        //shutting down the read side of a listening socket wakes up the blocked accepts (they fail with EINVAL)
+        if(::shutdown(servSockFd.get(), SHUT_RD) == -1){
+            int errorNo = errno;
+            downstreamClosed = false;
+            throw SnlException("System call error: ", errorNo);
+        }
+        //note: the state is not changed, the socket can only be closed or reset from here
     }
     
     void ServerSocketFsm::toNextStateImpl(const ServerClose&){
@@ -121,13 +218,27 @@ namespace snl{
 //        std::cout << "resetting socket" << std::endl;
         //close the socket (if there is no owned fd, nothing will happen)
         servSockFd.close();
-        //reset the blocking behavior to default
+        //reset the blocking behavior and the socket options to default
         nonBlockingIo = defaultIOBehav;
+        reusePort = false;
+        downstreamClosed = false;
         //no need to reset the sockaddr and the backlog (cannot be read, will throw error) so reset to init state
         fsmState = ServerFsmState::INIT;
     }
     
     
+    void ServerSocketFsm::setReusePort(bool reusePortVal){
+        //the option only has effect when set before the bind
+        if(servSockFd.ownsFd()){
+            throw SnlException("ServerSocket error: trying to change the port reuse of an already bound socket");
+        }
+        reusePort = reusePortVal;
+    }
+    
+    bool ServerSocketFsm::getReusePort(){
+        return reusePort;
+    }
+    
     bool ServerSocketFsm::getNonBlockIO(){
         return nonBlockingIo;
     }
@@ -181,6 +292,10 @@ namespace snl{
         return getSockAddr().getTcpPort();
     }
 
+    Fd ServerSocketFsm::getFd(){
+        return servSockFd.get();
+    }
+
     bool ServerSocketFsm::isBound(){
         return ServerFsmState::BOUND <= fsmState;
     }
@@ -193,6 +308,9 @@ namespace snl{
     bool ServerSocketFsm::isClosed(){
         return ServerFsmState::CLOSED == fsmState;
     }
+    bool ServerSocketFsm::isDownstreamClosed(){
+        return downstreamClosed;
+    }
     
     /*
      * Checks on the order of the fsm
@@ -5,6 +5,9 @@
 #include "TcpPort.h"
 #include "SocketAddress.h"
 #include "FdGuard.h"
+//cpp headers
+#include <atomic>
+#include <functional>
 
 namespace snl{
     
@@ -15,6 +18,8 @@ namespace snl{
     struct ServerListen { ServerListen () noexcept = default; };
 //    struct ServDefaultListen { ServDefaultListen() noexcept = default; };
     struct ServerAccept {ServerAccept() noexcept = default; };
+    struct ServerAcceptBatch {ServerAcceptBatch() noexcept = default; };
+    struct ServerDClose {ServerDClose() noexcept = default; };
     struct ServerClose {ServerClose() noexcept = default; };
     struct ServerReset {ServerReset() noexcept = default; };
     
@@ -23,6 +28,8 @@ namespace snl{
     constexpr ServerListen serverListen;
 //    constexpr ServDefaultListen defaultListenAction;
     constexpr ServerAccept serverAccept;
+    constexpr ServerAcceptBatch serverAcceptBatch;
+    constexpr ServerDClose serverDownstrClose;
     constexpr ServerClose serverClose;
     constexpr ServerReset serverReset;
     
@@ -33,10 +40,17 @@ namespace snl{
         //enum that contains the states of the fsm
         enum class ServerFsmState:uint8_t{INIT = 0, BOUND = 1, LISTENING = 2, ACCEPTING = 3, CLOSED = 4};
         
+        //receives every client accepted by a batch accept: the client fd and its address
+        using AcceptSink = std::function<void(FdGuard&& clientFd, const sockaddr_storage& clientSockaddr)>;
+        
         ServerSocketFsm() noexcept; //default constructor == ok
         ServerSocketFsm(const SocketAddress& address, int backlog);
         ~ServerSocketFsm();
         
+        //allocated from the state pool like the stream socket state
+        static void* operator new(std::size_t size);
+        static void operator delete(void* state, std::size_t size) noexcept;
+        
         template<typename Action, typename ...Args>
         void toNextState(const Action& action, Args&& ... args){
             //first do a static check
@@ -49,23 +63,30 @@ namespace snl{
         void setNonBlockIO(bool nonBlockVal); 
         bool getNonBlockIO();
         
+        void setReusePort(bool reusePortVal); //SO_REUSEPORT, must be set before binding
+        bool getReusePort();
+        
         SocketAddress getSockAddr();
         IpAddress getIpAddress();
         TcpPort getTcpPort();
+        Fd getFd();
         
         bool isBound();
         bool isListening();
         bool isAccepting();
         bool isClosed();
+        bool isDownstreamClosed(); //true if accepting was stopped by a downstream close
             
     private:
-        //todo try to move the correct order of execution to compile time by filling in the previous 
-        //state during to next state (static asserts on the previous and current state) ==> need to fill in a template parameter with the previous type and the next action
+        //the compile time order of execution lives in TypedSockets.h (one type per state), this fsm
+        //keeps the runtime checks for dynamic use
         //toNextState Implementations
         void toNextStateImpl(const ServerBind& , const SocketAddress& socketAddress); // action is bind
         void toNextStateImpl(const ServerListen& , int listenBacklog); //action is listen
 //        void toNextStateImpl(const ServDefaultListen& , TcpPort tcpPort, int listenBacklog); //action is default listen
         void toNextStateImpl(const ServerAccept&, FdGuard& clientFd, sockaddr_storage& clientSockaddr); //accept, put new guard and addr info in the references
+        void toNextStateImpl(const ServerAcceptBatch&, const AcceptSink& sink, std::size_t maxAccepts, std::size_t& accepted); //accept all pending clients (up to max), hand them to the sink
+        void toNextStateImpl(const ServerDClose& ); //stop accepting, wakes up blocked accepts (may be called from another thread)
         void toNextStateImpl(const ServerClose& ); //action is close
         void toNextStateImpl(const ServerReset& ); //action is reset
         
@@ -80,17 +101,26 @@ namespace snl{
         
         //general functions to make life easier
         //creates a socket fd for the given sockaddr and binds it to the created fd
-        static FdGuard makeSockFdAndBind(const SocketAddress& sockAddr);
+        static FdGuard makeSockFdAndBind(const SocketAddress& sockAddr, bool reusePortVal);
+        //fetches the address the fd is bound to (the kernel fills in the port if it was 0)
+        static SocketAddress getBoundSockAddr(const FdGuard& guard);
         //used to change fd
         void setFdBlockingBehav(FdGuard& guard, bool nonBlockVal);
+        //checks (without blocking) if a client is waiting to be accepted
+        static bool hasPendingClient(const FdGuard& guard);
+        //moves a listening socket to accepting, only the first accept writes the state
+        void markAccepting() noexcept;
         
         //datamembers
         SocketAddress socketAddr;
         FdGuard servSockFd;
         int backlog;
         bool nonBlockingIo = defaultIOBehav;
-        //the state of the fsm
-        ServerFsmState fsmState;
+        bool reusePort = false;
+        //set by the downstream close, atomic because it is meant to be called from another thread than the acceptor
+        std::atomic<bool> downstreamClosed{false};
+        //the state of the fsm, atomic because the accepts of a shared listener (ListenerGroup) run on several threads
+        std::atomic<ServerFsmState> fsmState{ServerFsmState::INIT};
         
         static constexpr bool defaultIOBehav = false;
     };
@@ -1,10 +1,13 @@
 #include "SocketAddress.h"
 
 //c headers
+#include <arpa/inet.h>
 #include <sys/select.h>
 #include <netinet/in.h>
 //cpp headers
 #include <cassert>
+#include <cstring>
+#include <string_view>
 //own headers
 #include "IpAddress.h"
 #include "SnlException.h"
@@ -15,63 +18,61 @@ namespace snl{
     constexpr std::size_t ipv4Addrlen = sizeof(sockaddr_in);
     constexpr std::size_t ipv6Addrlen = sizeof(sockaddr_in6);
     
-    struct SocketAddress::SockAddrImpl{
-        //use of pass by value: cheap to move ip addresses around and they MUST be copied in the first place
-        SockAddrImpl(IpAddress ipAddress, TcpPort port) noexcept : ipAddr(std::move(ipAddress)), tcpPort(port), addrlen(ipAddr.isIpv4() ? ipv4Addrlen : ipv6Addrlen)  { }
-        
-        IpAddress ipAddr;
-        TcpPort tcpPort;
-        std::size_t addrlen; //the size (in bytes) of the sockaddr that is built from the socket address
-    };
-    
-    SocketAddress::SocketAddress() : SocketAddress(std::move(IpAddress{}), 0) {} //create empty ip with no valid port
-    
-    SocketAddress::SocketAddress(IpAddress ipAddress, TcpPort tcpPort) : implPtr(std::make_unique<SockAddrImpl>(std::move(ipAddress), std::move(tcpPort))) { }
-    
-    //SocketAddress::SocketAddress(const std::string& hostname, TcpPort tcpPort) : implPtr(std::make_unique<SockAddrImpl>(IpAddress(hostname), tcpPort)) { } // a new ip addr must be created
-    //note: we need to copy all the fields (note that the ipAddress must be copied, so pass by value is justified again)
-    SocketAddress::SocketAddress(const SocketAddress& rhs) : implPtr(std::make_unique<SockAddrImpl>(rhs.implPtr->ipAddr, rhs.implPtr->tcpPort)){ }
-    
-    SocketAddress::SocketAddress(SocketAddress&& rhs) : implPtr(std::move(rhs.implPtr)) { }
-    
-    SocketAddress& SocketAddress::operator =(const SocketAddress& rhs){
-        SocketAddress temp = rhs;
-        using std::swap; //make available all the possible swaps
-        swap(*this, temp);
-        
-        return *this;
+    SocketAddress::SocketAddress() : SocketAddress(IpAddress{}, 0) {} //create localhost with no valid port
+    
+    SocketAddress::SocketAddress(IpAddress ipAddress, TcpPort tcpPort){
+        static_assert(sizeof(RawAddress) == sizeof(IpAddress::RawAddress), "the raw addresses must have the same layout");
+        //the ip address is already a zeroed raw sockaddr with port 0, only the port is filled in
+        std::memcpy(&raw, &ipAddress.raw, sizeof(raw));
+        if(ipAddress.isIpv4()){
+            raw.ipv4.sin_port = tcpPort.toNetworkByteOrder();
+        }else{
+            raw.ipv6.sin6_port = tcpPort.toNetworkByteOrder();
+        }
     }
     
-    SocketAddress& SocketAddress::operator =(SocketAddress&& rhs){
-        assert(this != &rhs);
-        this->implPtr = std::move(rhs.implPtr);
-        
-        return *this;
+    SocketAddress::SocketAddress(const sockaddr_storage& storage, std::size_t addrlen) noexcept{
+        std::memset(&raw, 0, sizeof(raw));
+        std::memcpy(&raw, &storage, addrlen);
     }
     
-    SocketAddress::~SocketAddress() = default;
-    
     /*
      * getters and setters
      */ 
-    IpAddress SocketAddress::getIpAddress() const noexcept{
-        return implPtr->ipAddr;
+    IpAddress SocketAddress::getIpAddress() const{
+        return IpAddress(getSockaddr());
+    }
+    
+    std::string SocketAddress::getIpString() const{
+        char ipString[INET6_ADDRSTRLEN]; //large enough for both families
+        if(raw.ipv4.sin_family == AF_INET){
+            inet_ntop(AF_INET, &raw.ipv4.sin_addr, ipString, INET6_ADDRSTRLEN);
+        }else{
+            inet_ntop(AF_INET6, &raw.ipv6.sin6_addr, ipString, INET6_ADDRSTRLEN);
+        }
+        return std::string(ipString);
     }
     
     TcpPort SocketAddress::getTcpPort() const noexcept{
-        return implPtr->tcpPort;
+        return TcpPort(ntohs(raw.ipv4.sin_family == AF_INET ? raw.ipv4.sin_port : raw.ipv6.sin6_port));
     }
     
     std::size_t SocketAddress::getAddrlen() const noexcept{
-        return implPtr->addrlen;
+        return raw.ipv4.sin_family == AF_INET ? ipv4Addrlen : ipv6Addrlen;
     }
     
     sockaddr_storage SocketAddress::getSockaddrStorage() const{
-        return implPtr->ipAddr.makeSockaddrStorage(implPtr->tcpPort);
+        sockaddr_storage storage{};
+        std::memcpy(&storage, &raw, sizeof(raw));
+        return storage;
+    }
+    
+    const sockaddr* SocketAddress::getSockaddr() const noexcept{
+        return reinterpret_cast<const sockaddr*>(&raw);
     }
         
-   std::size_t SocketAddress::getAddressFamily() const{
-        return implPtr->ipAddr.isIpv4() ? AF_INET : AF_INET6;
+   std::size_t SocketAddress::getAddressFamily() const noexcept{
+        return raw.ipv4.sin_family;
     }
     
     /*
@@ -79,8 +80,10 @@ namespace snl{
      */ 
     
     void swap(SocketAddress& lhs, SocketAddress& rhs){
-        using std::swap;
-        (lhs.implPtr).swap(rhs.implPtr); //swap the unique ptrs
+        //a plain value, swapping is three copies
+        SocketAddress temp = lhs;
+        lhs = rhs;
+        rhs = temp;
     }
     
     SocketAddress makeIpv4SockAddr(const std::string& ipv4String, TcpPort tcpPort){
@@ -93,7 +96,30 @@ namespace snl{
     }
     
     SocketAddress makeSockAddr(const sockaddr_storage& storage){
-        return SocketAddress(makeIpAddress(storage), makeTcpPort(storage));
+        //the accepted peer address stays raw, it is only decoded when asked for
+        if(storage.ss_family != AF_INET && storage.ss_family != AF_INET6){
+            throw SnlException("SocketAddress error: unknown address family");
+        }
+        return SocketAddress(storage, storage.ss_family == AF_INET ? ipv4Addrlen : ipv6Addrlen);
+    }
+    
+    bool operator==(const SocketAddress& lhs, const SocketAddress& rhs){
+        if(lhs.getAddrlen() != rhs.getAddrlen()){
+            return false;
+        }
+        //the raw sockaddrs are zero initialized, so they can be compared byte wise
+        return std::memcmp(lhs.getSockaddr(), rhs.getSockaddr(), lhs.getAddrlen()) == 0;
+    }
+    
+    bool operator!=(const SocketAddress& lhs, const SocketAddress& rhs){
+        return !(lhs == rhs);
     }
     
 }
+
+namespace std{
+    
+    std::size_t hash<snl::SocketAddress>::operator()(const snl::SocketAddress& sockAddr) const{
+        return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(sockAddr.getSockaddr()), sockAddr.getAddrlen()));
+    }
+}
@@ -2,14 +2,14 @@
 #define SOCKETADDRESS_H
 
 //c headers
-
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
 //cpp headers
+#include <functional>
 #include <string>
-#include <memory>
 //own headers
 
-//forward declarations
-struct sockaddr_storage;
 
 namespace snl{
     //some forward declarations
@@ -18,14 +18,16 @@ namespace snl{
     //type alias
     class TcpPort;
     
+    /**
+     * Socket address stored inline as the raw sockaddr that connect and bind take
+     * the address is a trivially copyable value (no allocation on copy or on accept), the ip address and
+     * the port are only decoded when they are asked for.
+     */
     class SocketAddress
     {
     public:
         
-        friend SocketAddress makeIpv4SockAddr(const std::string& ipv4String, TcpPort port);
-        friend SocketAddress makeIpv6SockAddr(const std::string& ipv6String, TcpPort port, u_int32_t flowInfo, u_int32_t scopeId);
         friend SocketAddress makeSockAddr(const sockaddr_storage& storage);
-        friend void swap(SocketAddress& lhs, SocketAddress& rhs);
         
         SocketAddress(); //creates a localhost address bound to port 0 (no valid port) --> note needed for server impl
         
@@ -33,19 +35,24 @@ namespace snl{
         SocketAddress(IpAddress ipAddress, TcpPort tcpPort); // by creation of an ip address
        // SocketAddress(const std::string& hostname, TcpPort tcpPort); // by creation of an hostname (slower)
         
-        SocketAddress(const SocketAddress& other);
-        SocketAddress(SocketAddress&& other);
+        SocketAddress(const SocketAddress& other) noexcept = default;
+        SocketAddress(SocketAddress&& other) noexcept = default;
         
-        SocketAddress& operator=(const SocketAddress& rhs);
-        SocketAddress& operator=(SocketAddress&& rhs);
+        SocketAddress& operator=(const SocketAddress& rhs) noexcept = default;
+        SocketAddress& operator=(SocketAddress&& rhs) noexcept = default;
         
-        ~SocketAddress();
+        ~SocketAddress() = default;
         
         /**
          * @brief getter for the ip address of the socket addr
          * @return the ip address representing the 
          */
-        IpAddress getIpAddress() const noexcept;
+        IpAddress getIpAddress() const;
+        
+        /**
+         * @brief the string form of the ip address, converted straight from the raw address
+         */
+        std::string getIpString() const;
         
         /**
          * @brief getter for the tcp port of the socket addr
@@ -64,16 +71,29 @@ namespace snl{
          */
         sockaddr_storage getSockaddrStorage() const;
         
+        /**
+         * @brief the raw address as connect and bind take it (getAddrlen bytes), valid as long as the socket address
+         */
+        const sockaddr* getSockaddr() const noexcept;
+        
         /**
          * getter for the address family corresponding to the stored ip address
          */ 
-        std::size_t getAddressFamily() const;
+        std::size_t getAddressFamily() const noexcept;
         
         
     private:
     
-        struct SockAddrImpl;
-        std::unique_ptr<SockAddrImpl> implPtr;
+        //copies the raw address of a known family (used by makeSockAddr, skips the localhost default)
+        explicit SocketAddress(const sockaddr_storage& storage, std::size_t addrlen) noexcept;
+    
+        //the raw address, zeroed beyond the used member so addresses compare and hash byte wise
+        union RawAddress{
+            sockaddr_in ipv4;
+            sockaddr_in6 ipv6;
+        };
+        
+        RawAddress raw;
     };
     
     /**
@@ -106,7 +126,22 @@ namespace snl{
      * @return a socket address corresponding to the provided sockaddr storage
      */
     SocketAddress makeSockAddr(const sockaddr_storage& storage);
+    
+    /**
+     * @brief compares the socket addresses (family, ip address, port and for ipv6 the flow info and scope id)
+     */
+    bool operator==(const SocketAddress& lhs, const SocketAddress& rhs);
+    bool operator!=(const SocketAddress& lhs, const SocketAddress& rhs);
 
 }
 
+namespace std{
+    
+    //hash of the socket address, consistent with operator== (used to key connection pools)
+    template<>
+    struct hash<snl::SocketAddress>{
+        std::size_t operator()(const snl::SocketAddress& sockAddr) const;
+    };
+}
+
 #endif // SOCKETADDRESS_H
@@ -1,15 +1,36 @@
 #include "StreamSocket.h"
 //c headers
 #include <cassert>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/socket.h>
 //cpp headers
-#include <sstream>
+#include <algorithm>
+#include <string_view>
+#include <vector>
 //own headers
 #include "StreamSocketFsm.h"
+#include "BufferPool.h"
 #include "IpAddress.h"
 #include "TcpPort.h"
+#include "Resolver.h"
+#include "FdGuard.h"
+#include "SnlException.h"
 namespace snl{
     
+    constexpr std::size_t maxTransferChunk = 0x7ffff000; //the most a single sendfile/splice transfers on linux
+    
+    //blocks until the fd is ready for the events (for the blocking transfers on non blocking sockets)
+    static void waitReady(int fd, short events){
+        pollfd pollFd{fd, events, 0};
+        while(::poll(&pollFd, 1, -1) == -1){
+            if(errno != EINTR){
+                throw SnlException("StreamSocket error: ", errno);
+            }
+        }
+    }
+    
     constexpr int messageDontWaitFlag = MSG_DONTWAIT; //flag that makes the socket non blocking for one call
     constexpr int MessageWaitFlag = MSG_WAITALL; //flag that makes the socket wait on a receive untill the message is sent
     
@@ -17,11 +38,15 @@ namespace snl{
 
     StreamSocket::~StreamSocket(){ }
     
-    StreamSocket::StreamSocket(StreamSocket&& rhs) : fsmImpl(std::move(rhs.fsmImpl)){ }
+    void StreamSocket::reserveStates(std::size_t count){ BufferPool::getStatePool().reserve(sizeof(StreamSocketFsm), count); }
+    
+    StreamSocket::StreamSocket(StreamSocket&& rhs) noexcept : fsmImpl(std::move(rhs.fsmImpl)){ }
     
-    StreamSocket::StreamSocket(FdGuard&& guard, const SocketAddress& sockAddr) : fsmImpl(std::make_unique<StreamSocketFsm>(std::move(guard), sockAddr)) { }
+    StreamSocket::StreamSocket(FdGuard&& guard, const SocketAddress& sockAddr, bool nonBlockVal) : fsmImpl(std::make_unique<StreamSocketFsm>(std::move(guard), sockAddr, nonBlockVal)) { }
     
-    StreamSocket& StreamSocket::operator=(StreamSocket&& rhs){
+    StreamSocket::StreamSocket(FdGuard&& guard, bool nonBlockVal) : fsmImpl(std::make_unique<StreamSocketFsm>(std::move(guard), nonBlockVal)) { }
+    
+    StreamSocket& StreamSocket::operator=(StreamSocket&& rhs) noexcept{
         assert(this != &rhs);
         this->fsmImpl = std::move(rhs.fsmImpl);
         return *this;
@@ -32,6 +57,20 @@ namespace snl{
     
     void StreamSocket::connect(const IpAddress& address, const TcpPort& tcpPort){ fsmImpl->toNextState(connectAct, SocketAddress(address, tcpPort));}
     
+    void StreamSocket::connect(const SocketAddress& sockAddr, std::chrono::milliseconds timeout){ fsmImpl->toNextState(connectAct, sockAddr, timeout); }
+    
+    void StreamSocket::connect(const IpAddress& address, const TcpPort& tcpPort, std::chrono::milliseconds timeout){ fsmImpl->toNextState(connectAct, SocketAddress(address, tcpPort), timeout); }
+    
+    void StreamSocket::connect(const std::string& hostname, const TcpPort& tcpPort, std::chrono::milliseconds attemptDelay){
+        std::vector<SocketAddress> candidates;
+        for(IpAddress& address : Resolver::getDefault().resolve(hostname)){
+            candidates.emplace_back(std::move(address), tcpPort);
+        }
+        fsmImpl->toNextState(connectAct, candidates, attemptDelay);
+    }
+    
+    void StreamSocket::connect(const char* hostname, const TcpPort& tcpPort, std::chrono::milliseconds attemptDelay){ connect(std::string(hostname), tcpPort, attemptDelay); }
+    
     std::size_t StreamSocket::send(const void* buffer, std::size_t bufferSize, int flags){
         std::size_t bytesSent = 0;
         fsmImpl->toNextState(sendAct, buffer, bufferSize, bytesSent, flags);
@@ -44,6 +83,94 @@ namespace snl{
         return bytesReceived;
     }
     
+    bool StreamSocket::trySend(const void* buffer, std::size_t bufferSize, std::size_t& bytesSent, int flags){
+        bool wouldBlock = false;
+        fsmImpl->toNextState(trySendAct, buffer, bufferSize, bytesSent, wouldBlock, flags);
+        return !wouldBlock;
+    }
+    
+    bool StreamSocket::tryReceive(void* buffer, std::size_t bufferSize, std::size_t& bytesReceived, int flags){
+        bool wouldBlock = false;
+        fsmImpl->toNextState(tryReceiveAct, buffer, bufferSize, bytesReceived, wouldBlock, flags);
+        return !wouldBlock;
+    }
+    
+    std::size_t StreamSocket::sendv(std::span<const iovec> segments, int flags){
+        std::size_t bytesSent = 0;
+        fsmImpl->toNextState(sendvAct, segments, bytesSent, flags);
+        return bytesSent;
+    }
+    
+    std::size_t StreamSocket::receivev(std::span<const iovec> segments, int flags){
+        std::size_t bytesReceived = 0;
+        fsmImpl->toNextState(receivevAct, segments, bytesReceived, flags);
+        return bytesReceived;
+    }
+    
+    bool StreamSocket::trySendv(std::span<const iovec> segments, std::size_t& bytesSent, int flags){
+        bool wouldBlock = false;
+        fsmImpl->toNextState(trySendvAct, segments, bytesSent, wouldBlock, flags);
+        return !wouldBlock;
+    }
+    
+    std::size_t StreamSocket::sendFile(int fileFd, off_t offset, std::size_t length){
+        std::size_t totalSent = 0;
+        while(totalSent != length){
+            std::size_t bytesSent = 0;
+            if(!trySendFile(fileFd, offset, std::min(length - totalSent, maxTransferChunk), bytesSent)){
+                waitReady(getFd(), POLLOUT);
+                continue;
+            }
+            if(bytesSent == 0){
+                break; //end of the file
+            }
+            totalSent += bytesSent;
+        }
+        return totalSent;
+    }
+    
+    std::size_t StreamSocket::sendFile(const std::string& path, off_t offset, std::size_t length){
+        FdGuard fileGuard = makeFdGuard(::open, path.c_str(), O_RDONLY | O_CLOEXEC);
+        return sendFile(fileGuard.get(), offset, length);
+    }
+    
+    bool StreamSocket::trySendFile(int fileFd, off_t& offset, std::size_t count, std::size_t& bytesSent){
+        bool wouldBlock = false;
+        fsmImpl->toNextState(sendFileAct, fileFd, offset, count, bytesSent, wouldBlock);
+        return !wouldBlock;
+    }
+    
+    std::size_t StreamSocket::receiveToFile(int fileFd, off_t offset, std::size_t length){
+        std::size_t totalReceived = 0;
+        try{
+            while(totalReceived != length){
+                std::size_t bytesReceived = 0;
+                if(!tryReceiveToFile(fileFd, offset, std::min(length - totalReceived, maxTransferChunk), bytesReceived)){
+                    waitReady(getFd(), POLLIN);
+                    continue;
+                }
+                totalReceived += bytesReceived;
+            }
+        }catch(SnlEofException&){
+            //the stream ended before length bytes were received, the caller sees the short count
+        }
+        return totalReceived;
+    }
+    
+    bool StreamSocket::tryReceiveToFile(int fileFd, off_t& offset, std::size_t count, std::size_t& bytesReceived){
+        bool wouldBlock = false;
+        fsmImpl->toNextState(receiveFileAct, fileFd, offset, count, bytesReceived, wouldBlock);
+        return !wouldBlock;
+    }
+    
+    bool StreamSocket::beginConnect(const SocketAddress& sockAddr){
+        bool connected = false;
+        fsmImpl->toNextState(connectStartAct, sockAddr, connected);
+        return connected;
+    }
+    
+    void StreamSocket::finishConnect(){ fsmImpl->toNextState(connectFinishAct); }
+    
     void StreamSocket::closeUpstream(){ fsmImpl->toNextState(upstrCloseAct);}
     
     void StreamSocket::closeDownstream(){ fsmImpl->toNextState(downstrCloseAct); }
@@ -58,12 +185,16 @@ namespace snl{
     
     bool StreamSocket::isNonBlock() const { return fsmImpl->isNonBlock(); }
     
+    int StreamSocket::getFd() const { return fsmImpl->getFd(); }
+    
     SocketAddress StreamSocket::getSocketAddress() const { return fsmImpl->getSockAddress(); }
     
     IpAddress StreamSocket::getIpAddress() const { return getSocketAddress().getIpAddress(); }
     
     TcpPort StreamSocket::getTcpPort() const{ return getSocketAddress().getTcpPort(); }
     
+    bool StreamSocket::isConnecting() const { return fsmImpl->isConnecting(); }
+    
     bool StreamSocket::isConnected() const { return fsmImpl->isConnected(); }
     
     bool StreamSocket::upstreamClosed() const { return fsmImpl->upstreamClosed(); }
@@ -72,36 +203,68 @@ namespace snl{
         
     bool StreamSocket::isClosed() const { return fsmImpl->isClosed(); }
     
-    std::size_t readline(StreamSocket& strSock, std::string& lineBuff, const std::string& eol){
-        lineBuff.clear();
-        char buff;
-        do{
-            strSock.receive(&buff, sizeof(char), MessageWaitFlag);
-            lineBuff.push_back(buff);
-        }while(lineBuff.rfind(eol)==std::string::npos);
-        
-        for(std::size_t i = 0; i != eol.size(); i++){
-            lineBuff.pop_back();
+    //peeks the available data into the buffer in chunks and consumes up to and including the delimiter
+    //makeRoom(used) must return the buffer with free space past the used bytes (an empty span past used when full)
+    template<typename MakeRoom>
+    static std::size_t readlinePeek(StreamSocket& strSock, std::string_view eol, MakeRoom makeRoom){
+        std::size_t used = 0; //bytes of the line consumed from the socket
+        while(true){
+            std::span<char> lineBuff = makeRoom(used);
+            if(lineBuff.size() == used){
+                throw SnlException("StreamSocket error: the line does not fit in the buffer: ", EMSGSIZE);
+            }
+            
+            std::size_t peeked = 0;
+            while(!strSock.tryReceive(lineBuff.data() + used, lineBuff.size() - used, peeked, MSG_PEEK)){
+                waitReady(strSock.getFd(), POLLIN);
+            }
+            //the delimiter may start in the bytes consumed before
+            std::size_t from = used >= eol.size() ? used - (eol.size() - 1) : 0;
+            std::string_view searched(lineBuff.data(), used + peeked);
+            std::size_t position = eol.empty() ? used : searched.find(eol, from);
+            if(position != std::string_view::npos){
+                //consume exactly up to the end of the delimiter, the rest stays in the socket
+                std::size_t lineEnd = position + eol.size();
+                strSock.receive(lineBuff.data() + used, lineEnd - used, MessageWaitFlag);
+                return position;
+            }
+            strSock.receive(lineBuff.data() + used, peeked, MessageWaitFlag);
+            used += peeked;
         }
-        
-        return lineBuff.size();
     }
     
-    void sendline(StreamSocket& strSock, const std::string& line, const std::string& eol){
-        //convert the line into a c-string
-        
-        std::ostringstream strBldr;
-        strBldr << line << eol;
-        std::string message = strBldr.str();
-        const char* msgBuff = message.c_str();
-        
-        std::size_t charsSent = 0;
-        std::size_t charsToSend = message.size();
-        
-        do{
-            charsSent += strSock.send((msgBuff + charsSent), charsToSend - charsSent);
-            
-        }while(charsSent  != charsToSend);
+    std::size_t readline(StreamSocket& strSock, std::string& lineBuff, std::string_view eol){
+        lineBuff.clear();
+        std::size_t lineSize = readlinePeek(strSock, eol, [&lineBuff](std::size_t used){
+            //grow geometrically, a long line costs a logarithmic number of peeks
+            lineBuff.resize(std::max<std::size_t>(used * 2, used + 256));
+            return std::span<char>(lineBuff.data(), lineBuff.size());
+        });
+        lineBuff.resize(lineSize);
+        return lineSize;
+    }
+    
+    std::size_t readline(StreamSocket& strSock, std::span<char> lineBuff, std::string_view eol){
+        return readlinePeek(strSock, eol, [lineBuff](std::size_t){ return lineBuff; });
+    }
+    
+    std::size_t readline(StreamSocket& strSock, std::pmr::string& lineBuff, std::string_view eol){
+        lineBuff.clear();
+        std::size_t lineSize = readlinePeek(strSock, eol, [&lineBuff](std::size_t used){
+            lineBuff.resize(std::max<std::size_t>(used * 2, used + 256));
+            return std::span<char>(lineBuff.data(), lineBuff.size());
+        });
+        lineBuff.resize(lineSize);
+        return lineSize;
+    }
+    
+    void sendline(StreamSocket& strSock, std::string_view line, std::string_view eol){
+        //the line and the delimiter are sent as two segments, no need to join them first
+        const iovec segments[] = {
+            {const_cast<char*>(line.data()), line.size()},
+            {const_cast<char*>(eol.data()), eol.size()}
+        };
+        sendAllv(strSock, segments);
     }
     
     void sendBuff(StreamSocket& strSock, const void* buffer, std::size_t bufferSize){
@@ -119,6 +282,44 @@ namespace snl{
     }
     
     
+    void sendAllv(StreamSocket& strSock, std::span<const iovec> segments){
+        //skip the empty segments up front, the loop below relies on every segment holding data
+        while(!segments.empty() && segments.front().iov_len == 0){
+            segments = segments.subspan(1);
+        }
+        
+        //copy of the list, made on the first partial write (short lists stay on the stack)
+        constexpr std::size_t inlineSegments = 8;
+        iovec inlineCopy[inlineSegments];
+        std::vector<iovec> heapCopy;
+        std::span<iovec> remaining;
+        while(!segments.empty()){
+            std::size_t bytesSent = strSock.sendv(segments);
+            
+            //drop the segments that were sent completely
+            while(!segments.empty() && bytesSent >= segments.front().iov_len){
+                bytesSent -= segments.front().iov_len;
+                segments = segments.subspan(1);
+            }
+            if(bytesSent != 0){
+                //the write stopped inside the first segment, only the list entry is adjusted, never the data
+                if(remaining.empty()){
+                    if(segments.size() <= inlineSegments){
+                        remaining = std::span<iovec>(inlineCopy, segments.size());
+                    }else{
+                        heapCopy.resize(segments.size());
+                        remaining = heapCopy;
+                    }
+                    std::copy(segments.begin(), segments.end(), remaining.begin());
+                    segments = remaining;
+                }
+                iovec& first = remaining[segments.data() - remaining.data()];
+                first.iov_base = static_cast<char*>(first.iov_base) + bytesSent;
+                first.iov_len -= bytesSent;
+            }
+        }
+    }
+    
     std::size_t receiveBuff(StreamSocket& strSock, void* buffer, std::size_t bufferSize){
         //just do one call the receive, will not block the caller (good for multithreaded implementations)
         return strSock.receive(buffer, bufferSize, messageDontWaitFlag);
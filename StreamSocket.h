@@ -1,8 +1,15 @@
 #ifndef STREAMSOCKET_H
 #define STREAMSOCKET_H
 //c headers
+#include <sys/types.h>
+#include <sys/uio.h>
 //cpp headers
+#include <chrono>
 #include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
 //own headeres
 namespace snl{
         
@@ -18,10 +25,12 @@ namespace snl{
     public:
         
         friend class ServerSocket;
+        friend class UringBackend;
+        friend class ConnectedStream;
         
         StreamSocket();
-        StreamSocket(StreamSocket&& rhs);
-        StreamSocket& operator=(StreamSocket&& rhs);
+        StreamSocket(StreamSocket&& rhs) noexcept;
+        StreamSocket& operator=(StreamSocket&& rhs) noexcept;
         ~StreamSocket();
         
         StreamSocket(const StreamSocket& rhs) = delete;
@@ -30,9 +39,102 @@ namespace snl{
         void connect(const SocketAddress& sockAddr); // pass by value, the result is always copied
         void connect(const IpAddress& address, const TcpPort& tcpPort); //pass by value, result is always copied
         
+        /**
+         * @brief connects to the address, waiting at most the timeout for the connection to complete
+         * @throws SnlException with ETIMEDOUT as error if the connection did not complete in time
+         */
+        void connect(const SocketAddress& sockAddr, std::chrono::milliseconds timeout);
+        void connect(const IpAddress& address, const TcpPort& tcpPort, std::chrono::milliseconds timeout);
+        
+        /**
+         * @brief connects to the hostname, racing all of its addresses (happy eyeballs, RFC 8305)
+         * @param hostname the hostname to resolve, every A and AAAA record is a candidate
+         * @param tcpPort the port to connect to
+         * @param attemptDelay the delay before the next address is tried while the previous connects are pending
+         * note: the first connection to complete is kept, a broken ipv6 path only costs the attempt delay
+         */
+        void connect(const std::string& hostname, const TcpPort& tcpPort, std::chrono::milliseconds attemptDelay = defaultAttemptDelay);
+        void connect(const char* hostname, const TcpPort& tcpPort, std::chrono::milliseconds attemptDelay = defaultAttemptDelay); //avoids the ambiguity with the ip address overload
+        
         std::size_t send(const void* buffer, std::size_t bufferSize, int flags = 0); //send primitive will return the number of bytes written
         std::size_t receive(void* buffer, std::size_t bufferSize, int flags = 0); //receive primitive (will ensure data is received)
         
+        /**
+         * @brief send that never reports EAGAIN as an error
+         * @param bytesSent set to the number of bytes written (0 if the call would block)
+         * @return false if the call would block (the socket must be non blocking or MSG_DONTWAIT must be set)
+         */
+        bool trySend(const void* buffer, std::size_t bufferSize, std::size_t& bytesSent, int flags = 0);
+        
+        /**
+         * @brief receive that never reports EAGAIN as an error
+         * @param bytesReceived set to the number of bytes read (0 if the call would block)
+         * @return false if the call would block, the end of the stream still throws an SnlEofException
+         */
+        bool tryReceive(void* buffer, std::size_t bufferSize, std::size_t& bytesReceived, int flags = 0);
+        
+        /**
+         * @brief gather send: writes the segments in order with a single system call
+         * @return the number of bytes written, may end in the middle of a segment (see sendAllv)
+         * note: at most IOV_MAX segments are sent per call
+         */
+        std::size_t sendv(std::span<const iovec> segments, int flags = 0);
+        
+        /**
+         * @brief scatter receive: fills the segments in order with a single system call
+         * @return the number of bytes received, the end of the stream throws an SnlEofException
+         */
+        std::size_t receivev(std::span<const iovec> segments, int flags = 0);
+        
+        /**
+         * @brief gather send that never reports EAGAIN as an error (see trySend)
+         */
+        bool trySendv(std::span<const iovec> segments, std::size_t& bytesSent, int flags = 0);
+        
+        /**
+         * @brief sends length bytes of the file starting at offset, straight from the page cache (sendfile)
+         * @return the number of bytes sent, less than length only if the file ended first
+         * note: blocks until done, also on a non blocking socket (use trySendFile on an event loop)
+         */
+        std::size_t sendFile(int fileFd, off_t offset, std::size_t length);
+        std::size_t sendFile(const std::string& path, off_t offset = 0, std::size_t length = toFileEnd);
+        
+        /**
+         * @brief a single sendfile call that never reports EAGAIN as an error
+         * @param offset advanced by the bytes sent, the progress of the transfer
+         * @param bytesSent set to the number of bytes sent (0 at the end of the file or if the call would block)
+         * @return false if the call would block
+         */
+        bool trySendFile(int fileFd, off_t& offset, std::size_t count, std::size_t& bytesSent);
+        
+        /**
+         * @brief receives length bytes into the file starting at offset, without a user space buffer (splice through a pipe)
+         * @return the number of bytes received, less than length only if the stream ended first
+         * note: blocks until done, also on a non blocking socket (use tryReceiveToFile on an event loop)
+         */
+        std::size_t receiveToFile(int fileFd, off_t offset, std::size_t length);
+        
+        /**
+         * @brief a single splice from the socket into the file that never reports EAGAIN as an error
+         * @param offset advanced by the bytes received, the progress of the transfer
+         * @return false if the call would block, the end of the stream throws an SnlEofException
+         */
+        bool tryReceiveToFile(int fileFd, off_t& offset, std::size_t count, std::size_t& bytesReceived);
+        
+        /**
+         * @brief starts connecting to the address without blocking
+         * @return true if the connection completed immediately, false if it is in progress
+         *         (wait until the socket is writable, then call finishConnect)
+         * note: the socket is blocking again once connected unless it was set to non blocking
+         */
+        bool beginConnect(const SocketAddress& sockAddr);
+        
+        /**
+         * @brief completes a connect started by beginConnect
+         * @throws SnlException if the connect failed, the socket can then be connected again
+         */
+        void finishConnect();
+        
         void closeUpstream(); //closes the upstream
         void closeDownstream(); //closes the downstream
         void close(); //closes the socket
@@ -43,18 +145,32 @@ namespace snl{
         void setNonBlockIO(bool nonBlockVal); //sets the socket to blocking/nonblocking
         bool isNonBlock() const;
         
+        int getFd() const; //the underlying file descriptor (for event loops), -1 if there is none
+        
         SocketAddress getSocketAddress()const;
         IpAddress getIpAddress()const;
         TcpPort getTcpPort()const;
         
+        bool isConnecting() const; //true between beginConnect and finishConnect
         bool isConnected() const ;
         bool upstreamClosed() const;
         bool downStreamClosed() const;
         bool isClosed() const;
         
+        /**
+         * @brief pre-sizes the pool the socket state is allocated from for count sockets
+         * note: call before a connection storm, the accepted sockets then take their state from the free lists
+         *       and the state goes back to the pool when the socket is destroyed
+         */
+        static void reserveStates(std::size_t count);
+        
+        static constexpr std::chrono::milliseconds defaultAttemptDelay{250}; //recommended by RFC 8305
+        static constexpr std::size_t toFileEnd = static_cast<std::size_t>(-1); //sendFile length that sends up to the end of the file
+        
     private:
     
-        StreamSocket(FdGuard&& guard, const SocketAddress& sockAddr); //constructor used by the server socket
+        StreamSocket(FdGuard&& guard, const SocketAddress& sockAddr, bool nonBlockVal = false); //constructor used by the server socket
+        StreamSocket(FdGuard&& guard, bool nonBlockVal); //the peer address is fetched when it is first asked for
         std::unique_ptr<StreamSocketFsm> fsmImpl;
     };
     
@@ -67,8 +183,9 @@ namespace snl{
      * @param line the line to send
      * @param eol the end of line delimiter
      * note: will always block until the message is completely sent (independent of the socket behavior)
+     * note: the line and the delimiter are sent as two segments of one gather send, nothing is allocated
      */
-    void sendline(StreamSocket& strSock, const std::string& line, const std::string& eol = "\r\n");
+    void sendline(StreamSocket& strSock, std::string_view line, std::string_view eol = "\r\n");
     
     /**
      * @brief Call that reads a single line from the connected host
@@ -76,8 +193,25 @@ namespace snl{
      * @param lineBuff the buffer used to store the recieved line in
      * @param eol the end of line delimiter
      * note: will always block untill a line is completely read (independent of the socket non blocking behavior)
+     * note: the available data is peeked (MSG_PEEK) in chunks and only the bytes up to the delimiter are consumed,
+     *       nothing past the line is read. Use a BufferedStreamReader when the socket is only read line by line,
+     *       it needs half the system calls.
+     */
+    std::size_t readline(StreamSocket& strSock, std::string& lineBuff, std::string_view eol = "\r\n");
+    
+    /**
+     * @brief readline into a caller owned fixed buffer, never allocates
+     * @param lineBuff the buffer, must hold the line and the delimiter
+     * @return the size of the line (the line starts at the front of the buffer, the delimiter follows it)
+     * @throws SnlException with EMSGSIZE if the line does not fit (the bytes read so far are consumed)
      */
-    std::size_t readline(StreamSocket& strSock, std::string& lineBuff, const std::string& eol = "\r\n");
+    std::size_t readline(StreamSocket& strSock, std::span<char> lineBuff, std::string_view eol = "\r\n");
+    
+    /**
+     * @brief readline into a polymorphic allocator string, e.g. backed by a std::pmr::monotonic_buffer_resource
+     *        that is reset per request so the lines never reach the heap
+     */
+    std::size_t readline(StreamSocket& strSock, std::pmr::string& lineBuff, std::string_view eol = "\r\n");
     
     /**
      * @brief Call that sents the complete buffer to the connected host
@@ -88,6 +222,14 @@ namespace snl{
      */
     void sendBuff(StreamSocket& strSock, const void* buffer, std::size_t bufferSize);
     
+    /**
+     * @brief Call that sends all the segments to the connected host (e.g. a header and a payload without copying them together)
+     * @param strSock the socket used to send the data
+     * @param segments the buffers to send, in order
+     * note: call will always block untill every segment is sent, a partial write continues inside the segment it stopped in
+     */
+    void sendAllv(StreamSocket& strSock, std::span<const iovec> segments);
+    
     /**
      * @brief Call receives data and puts it inside the buffer
      * @param strSock the stream socket that is used to receive the data
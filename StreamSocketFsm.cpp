@@ -1,11 +1,16 @@
 #include "StreamSocketFsm.h"
 //c headers
+#include <cerrno>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/sendfile.h>
+#include <climits>
 //cpp headers
-#include <iostream>
+#include <algorithm>
 //own headers
+#include "BufferPool.h"
 
 //declare extern c function to prevent mangled names:
 extern "C" {
@@ -24,38 +29,180 @@ namespace snl{
     
     StreamSocketFsm::StreamSocketFsm() : fsmState(StrSoFsmState::INIT){ }
     
-    StreamSocketFsm::StreamSocketFsm(FdGuard&& fdGuard, SocketAddress socketAddress_) : //pass by value is justified (will always be copied)
-         socketAddress(std::move(socketAddress_)), strSoFd(std::move(fdGuard)), fsmState(StrSoFsmState::CONNECTED) { std::cout << "created socket with server" << std::endl; }
+    StreamSocketFsm::StreamSocketFsm(FdGuard&& fdGuard, SocketAddress socketAddress_, bool nonBlockVal) : //pass by value is justified (will always be copied)
+         socketAddress(std::move(socketAddress_)), strSoFd(std::move(fdGuard)), nonBlock(nonBlockVal), fsmState(StrSoFsmState::CONNECTED) { }
+
+    StreamSocketFsm::StreamSocketFsm(FdGuard&& fdGuard, bool nonBlockVal) :
+         addressKnown(false), strSoFd(std::move(fdGuard)), nonBlock(nonBlockVal), fsmState(StrSoFsmState::CONNECTED) { }
 
     StreamSocketFsm::~StreamSocketFsm(){}
     
+    void* StreamSocketFsm::operator new(std::size_t size){
+        std::size_t capacity = 0;
+        return BufferPool::getStatePool().allocate(size, capacity);
+    }
+    
+    void StreamSocketFsm::operator delete(void* state, std::size_t size) noexcept{
+        BufferPool& statePool = BufferPool::getStatePool();
+        statePool.deallocate(static_cast<char*>(state), statePool.getCapacity(size));
+    }
+    
 
     void StreamSocketFsm::toNextStateImpl(const StrSoConnect&, const SocketAddress& socketAddress){ //do not a pass by value, if the check throws, unescessary copy
-        std::cout << ((&socketAddress) == nullptr) << std::endl;
-        std::cout << (this == nullptr) << std::endl;
+        toNextStateImpl(connectAct, socketAddress, noTimeout);
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoConnect&, const SocketAddress& socketAddress, std::chrono::milliseconds timeout){
         connectCheck(fsmState); // will detect wrong order
         //create and connect the socket
-        FdGuard guard = createSockAndConnect(socketAddress, isNonBlock());
+        FdGuard guard = createSockAndConnect(socketAddress, isNonBlock(), timeout);
         //then save the socket address && fd
-        this->socketAddress = std::move(socketAddress);
+        this->socketAddress = socketAddress;
         this->strSoFd = std::move(guard);
         //set the state to connected
         fsmState = StrSoFsmState::CONNECTED;
     }
     
-    FdGuard StreamSocketFsm::createSockAndConnect(const SocketAddress& address, bool nonBlockVal){
-        FdGuard guard = makeFdGuard(::socket, address.getAddressFamily(), SOCK_STREAM, 0);
-        //then connect based on the socket address
-        int failure = -1;
-        sockaddr_storage hostStorage = address.getSockaddrStorage();
-        sockaddr* hostSpec = reinterpret_cast<sockaddr*>(&hostStorage);
-        executeSyscall(::connect, failure, guard.get(), hostSpec, address.getAddrlen());
+    void StreamSocketFsm::toNextStateImpl(const StrSoConnect&, const std::vector<SocketAddress>& candidates, std::chrono::milliseconds attemptDelay){
+        connectCheck(fsmState);
+        if(candidates.empty()){
+            throw SnlException("StreamSocket error: connect fail, no addresses to connect to");
+        }
+        
+        using Clock = std::chrono::steady_clock;
+        std::vector<FdGuard> attempts; //the connects in flight
+        std::vector<pollfd> pollSpecs;
+        std::vector<std::size_t> attemptAddress; //the candidate of every attempt
+        std::size_t nextCandidate = 0;
+        std::size_t winner = candidates.size(); //index into the attempts
+        Clock::time_point nextAttempt = Clock::now();
+        int lastError = 0;
+        
+        while(winner == candidates.size()){
+            Clock::time_point now = Clock::now();
+            //start the next attempt when the delay passed or when nothing is in flight anymore
+            if(nextCandidate != candidates.size() && (attempts.empty() || now >= nextAttempt)){
+                try{
+                    bool connected = false;
+                    FdGuard guard = createSockAndStartConnect(candidates[nextCandidate], connected);
+                    attempts.push_back(std::move(guard));
+                    pollSpecs.push_back(pollfd{attempts.back().get(), POLLOUT, 0});
+                    attemptAddress.push_back(nextCandidate);
+                    if(connected){
+                        winner = attempts.size() - 1;
+                    }
+                }catch(SnlException& e){
+                    lastError = e.getErrorNo(); //e.g. no route for this family, move on to the next address
+                }
+                nextCandidate++;
+                nextAttempt = now + attemptDelay;
+                continue;
+            }
+            
+            if(attempts.empty()){
+                throw SnlException("StreamSocket error: connect fail: ", lastError);
+            }
+            
+            int waitMs = -1;
+            if(nextCandidate != candidates.size()){
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(nextAttempt - now);
+                waitMs = static_cast<int>(std::max<std::chrono::milliseconds::rep>(remaining.count(), 0));
+            }
+            int ready = ::poll(pollSpecs.data(), pollSpecs.size(), waitMs);
+            if(ready == -1 && errno != EINTR){
+                throw SnlException("StreamSocket error: connect fail: ", errno);
+            }
+            
+            for(std::size_t i = 0; ready > 0 && i != attempts.size() && winner == candidates.size();){
+                if(pollSpecs[i].revents == 0){
+                    i++;
+                    continue;
+                }
+                int connectError = getConnectError(attempts[i]);
+                if(connectError == 0){
+                    winner = i;
+                    break;
+                }
+                //failed attempt: drop it and start the next candidate right away
+                lastError = connectError;
+                attempts.erase(attempts.begin() + i);
+                pollSpecs.erase(pollSpecs.begin() + i);
+                attemptAddress.erase(attemptAddress.begin() + i);
+                nextAttempt = Clock::now();
+            }
+        }
+        
+        FdGuard guard = std::move(attempts[winner]);
+        if(!isNonBlock()){
+            setFdBlockingBehav(guard, false);
+        }
+        this->socketAddress = candidates[attemptAddress[winner]];
+        this->strSoFd = std::move(guard);
+        fsmState = StrSoFsmState::CONNECTED;
+        //the other attempts are closed when their guards go out of scope
+    }
+    
+    FdGuard StreamSocketFsm::createSockAndConnect(const SocketAddress& address, bool nonBlockVal, std::chrono::milliseconds timeout){
+        //the fd is non blocking during the connect, so an unreachable host can not block longer than the timeout
+        bool connected = false;
+        FdGuard guard = createSockAndStartConnect(address, connected);
+        if(!connected){
+            waitConnected(guard, timeout);
+        }
+        
+        if(!nonBlockVal){
+            setFdBlockingBehav(guard, nonBlockVal);
+        }
         
-        setFdBlockingBehav(guard, nonBlockVal);
+        return guard;
+    }
+    
+    FdGuard StreamSocketFsm::createSockAndStartConnect(const SocketAddress& address, bool& connected){
+        FdGuard guard = makeFdGuard(::socket, address.getAddressFamily(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        //then connect based on the socket address
+        int status = ::connect(guard.get(), address.getSockaddr(), address.getAddrlen());
+        if(status == -1 && errno != EINPROGRESS){
+            throw SnlException("StreamSocket error: connect fail: ", errno);
+        }
+        connected = status == 0; //loopback connects can complete immediately
         
         return guard;
     }
     
+    void StreamSocketFsm::waitConnected(FdGuard& guard, std::chrono::milliseconds timeout){
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point deadline = Clock::now() + timeout;
+        pollfd pollSpec{guard.get(), POLLOUT, 0};
+        int ready = 0;
+        do{
+            int waitMs = -1;
+            if(timeout != noTimeout){
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+                waitMs = static_cast<int>(std::max<std::chrono::milliseconds::rep>(remaining.count(), 0));
+            }
+            ready = ::poll(&pollSpec, 1, waitMs);
+            if(ready == -1 && errno != EINTR){
+                throw SnlException("StreamSocket error: connect fail: ", errno);
+            }
+            if(ready == 0){
+                throw SnlException("StreamSocket error: connect timed out: ", ETIMEDOUT);
+            }
+        }while(ready == -1); //interrupted, wait for the remainder
+        
+        int connectError = getConnectError(guard);
+        if(connectError != 0){
+            throw SnlException("StreamSocket error: connect fail: ", connectError);
+        }
+    }
+    
+    int StreamSocketFsm::getConnectError(FdGuard& guard){
+        int failure = -1;
+        int connectError = 0;
+        socklen_t errorLen = sizeof(connectError);
+        executeSyscall(::getsockopt, failure, guard.get(), SOL_SOCKET, SO_ERROR, &connectError, &errorLen);
+        return connectError;
+    }
+    
     void StreamSocketFsm::toNextStateImpl(const StrSoSend&, const void* buffer, std::size_t bufferSize, std::size_t& bytesSent, int flags){
         sendCheck(fsmState);
         int failure = -1;
@@ -73,6 +220,153 @@ namespace snl{
             throw SnlEofException("End of file reached");
         }
     }
+    void StreamSocketFsm::toNextStateImpl(const StrSoTrySend&, const void* buffer, std::size_t bufferSize, std::size_t& bytesSent, bool& wouldBlock, int flags){
+        sendCheck(fsmState);
+        ssize_t status = ::send(strSoFd.get(), buffer, bufferSize, flags);
+        wouldBlock = status == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if(status == -1 && !wouldBlock){
+            throw SnlException("System call error: ", errno);
+        }
+        bytesSent = wouldBlock ? 0 : static_cast<std::size_t>(status);
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoTryReceive&, void* buffer, std::size_t bufferSize, std::size_t& bytesReceived, bool& wouldBlock, int flags){
+        receiveCheck(fsmState);
+        ssize_t status = ::recv(strSoFd.get(), buffer, bufferSize, flags);
+        wouldBlock = status == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if(status == -1 && !wouldBlock){
+            throw SnlException("System call error: ", errno);
+        }
+        bytesReceived = wouldBlock ? 0 : static_cast<std::size_t>(status);
+        //same eof detection as the blocking receive
+        if(!wouldBlock && bytesReceived == 0 && bufferSize != 0){
+            throw SnlEofException("End of file reached");
+        }
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoSendv&, std::span<const iovec> segments, std::size_t& bytesSent, int flags){
+        sendCheck(fsmState);
+        int failure = -1;
+        msghdr message = makeMessage(segments);
+        bytesSent = executeSyscall(::sendmsg, failure, strSoFd.get(), &message, flags);
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoReceivev&, std::span<const iovec> segments, std::size_t& bytesReceived, int flags){
+        receiveCheck(fsmState);
+        int failure = -1;
+        msghdr message = makeMessage(segments);
+        bytesReceived = executeSyscall(::recvmsg, failure, strSoFd.get(), &message, flags);
+        //same eof detection as the single buffer receive
+        if(bytesReceived == 0){
+            for(const iovec& segment : segments.first(message.msg_iovlen)){
+                if(segment.iov_len != 0){
+                    throw SnlEofException("End of file reached");
+                }
+            }
+        }
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoTrySendv&, std::span<const iovec> segments, std::size_t& bytesSent, bool& wouldBlock, int flags){
+        sendCheck(fsmState);
+        msghdr message = makeMessage(segments);
+        ssize_t status = ::sendmsg(strSoFd.get(), &message, flags);
+        wouldBlock = status == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if(status == -1 && !wouldBlock){
+            throw SnlException("System call error: ", errno);
+        }
+        bytesSent = wouldBlock ? 0 : static_cast<std::size_t>(status);
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoSendFile&, Fd fileFd, off_t& offset, std::size_t count, std::size_t& bytesSent, bool& wouldBlock){
+        sendCheck(fsmState);
+        ssize_t status = ::sendfile(strSoFd.get(), fileFd, &offset, count);
+        wouldBlock = status == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if(status == -1 && !wouldBlock){
+            throw SnlException("StreamSocket error: sendfile fail: ", errno);
+        }
+        bytesSent = wouldBlock ? 0 : static_cast<std::size_t>(status);
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoReceiveFile&, Fd fileFd, off_t& offset, std::size_t count, std::size_t& bytesReceived, bool& wouldBlock){
+        receiveCheck(fsmState);
+        ensureSplicePipe();
+        //the pipe is empty, so only the socket can block (depending on its own blocking behavior)
+        ssize_t status = ::splice(strSoFd.get(), nullptr, spliceWrite.get(), nullptr, std::min(count, spliceCapacity), SPLICE_F_MOVE);
+        wouldBlock = status == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if(status == -1 && !wouldBlock){
+            throw SnlException("StreamSocket error: splice fail: ", errno);
+        }
+        bytesReceived = wouldBlock ? 0 : static_cast<std::size_t>(status);
+        if(!wouldBlock && bytesReceived == 0 && count != 0){
+            throw SnlEofException("End of file reached");
+        }
+        
+        //drain the pipe completely into the file, nothing may stay behind for the next call
+        std::size_t bytesWritten = 0;
+        while(bytesWritten != bytesReceived){
+            ssize_t written = ::splice(spliceRead.get(), nullptr, fileFd, &offset, bytesReceived - bytesWritten, SPLICE_F_MOVE);
+            if(written == -1 && errno == EINTR){
+                continue;
+            }
+            if(written <= 0){
+                int errorNo = written == -1 ? errno : EIO;
+                //the pipe content is lost, drop the pipe so the next call starts empty
+                spliceRead.close();
+                spliceWrite.close();
+                throw SnlException("StreamSocket error: splice to file fail: ", errorNo);
+            }
+            bytesWritten += static_cast<std::size_t>(written);
+        }
+    }
+    
+    void StreamSocketFsm::ensureSplicePipe(){
+        if(spliceRead.ownsFd()){
+            return;
+        }
+        int failure = -1;
+        int pipeFds[2];
+        executeSyscall(::pipe2, failure, pipeFds, O_CLOEXEC);
+        spliceRead.reset(pipeFds[0]);
+        spliceWrite.reset(pipeFds[1]);
+        spliceCapacity = static_cast<std::size_t>(executeSyscall(::fcntl, failure, pipeFds[1], F_GETPIPE_SZ));
+    }
+    
+    msghdr StreamSocketFsm::makeMessage(std::span<const iovec> segments){
+        msghdr message{};
+        //the kernel only reads the segments, the cast is needed because msghdr is used for both directions
+        message.msg_iov = const_cast<iovec*>(segments.data());
+        message.msg_iovlen = std::min<std::size_t>(segments.size(), IOV_MAX);
+        return message;
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoConnectStart&, const SocketAddress& socketAddress, bool& connected){
+        connectCheck(fsmState);
+        //the connect itself must never block, the saved behavior is restored once connected
+        FdGuard guard = createSockAndStartConnect(socketAddress, connected);
+        if(connected && !isNonBlock()){
+            setFdBlockingBehav(guard, false);
+        }
+        this->socketAddress = socketAddress;
+        this->strSoFd = std::move(guard);
+        fsmState = connected ? StrSoFsmState::CONNECTED : StrSoFsmState::CONNECTING;
+    }
+    
+    void StreamSocketFsm::toNextStateImpl(const StrSoConnectFinish&){
+        connectFinishCheck(fsmState);
+        int connectError = getConnectError(strSoFd);
+        if(connectError != 0){
+            //back to init, the socket can be connected again
+            strSoFd.close();
+            fsmState = StrSoFsmState::INIT;
+            throw SnlException("StreamSocket error: connect fail: ", connectError);
+        }
+        
+        if(!isNonBlock()){
+            setFdBlockingBehav(strSoFd, false);
+        }
+        fsmState = StrSoFsmState::CONNECTED;
+    }
+    
     void StreamSocketFsm::toNextStateImpl(const StrSoUClose&){
         upstreamCloseCheck(fsmState);
        
@@ -119,6 +413,7 @@ namespace snl{
         //to reset the socket goto init and set the other stuff to null
         strSoFd.close();
         socketAddress = SocketAddress();
+        addressKnown = true;
         nonBlock = defaultNonBlock;
         fsmState = StrSoFsmState::INIT;
         //done
@@ -126,25 +421,29 @@ namespace snl{
     
     void StreamSocketFsm::toNextStateImpl(const StrSoReConnect&){
         resetConnectCheck(fsmState);
+        //read the address first, a lazily constructed socket fetches it from the fd that is closed next
+        SocketAddress peerAddress = getSockAddress();
         strSoFd.close(); //will close the socket in case of owning a socket
-        strSoFd = std::move(createSockAndConnect(getSockAddress(), isNonBlock()));
+        strSoFd = std::move(createSockAndConnect(peerAddress, isNonBlock()));
         fsmState = StrSoFsmState::CONNECTED;
     }
     
     void StreamSocketFsm::setNonBlock(bool nonBlockVal){
-        std::cout << "setting non block to " << std::boolalpha << nonBlockVal << std::noboolalpha << std::endl;
-
         //first check if the current blocking value is already the desired one
         if(nonBlock == nonBlockVal){
             return; //already desired, skip this
         }
         
         //then check if we already own a fd, if not, save flag for later (upon connection the socket will be set to nonblock)
-        if(fsmState == StrSoFsmState::INIT){
+        if(!strSoFd.ownsFd()){
+            nonBlock = nonBlockVal;
             return;
         }
         //else we set the blocking/nonblocking behav
         setFdBlockingBehav(strSoFd, nonBlockVal);
+        
+        //save the flag after the syscall (exception safety)
+        nonBlock = nonBlockVal;
     }
     
     void StreamSocketFsm::setFdBlockingBehav(FdGuard& guard, bool nonBlockVal){
@@ -159,7 +458,6 @@ namespace snl{
         }
         //then set the new flags
         executeSyscall(::fcntl, failure,guard.get(),  F_SETFL, flags);
-        std::cout << "changed blocking behavior" << std::endl;
     }
     
     
@@ -172,12 +470,27 @@ namespace snl{
             throw SnlException("ServerSocket error: trying to get the socket address from unconnected socket");
         }
         
+        if(!addressKnown){
+            sockaddr_storage storage{};
+            socklen_t addrlen = sizeof(sockaddr_storage);
+            int failure = -1;
+            executeSyscall(::getpeername, failure, strSoFd.get(), reinterpret_cast<sockaddr*>(&storage), &addrlen);
+            socketAddress = makeSockAddr(storage);
+            addressKnown = true;
+        }
         return socketAddress;
     }
     
+    Fd StreamSocketFsm::getFd(){
+        return strSoFd.get();
+    }
+    
     bool StreamSocketFsm::isNonBlock(){
         return nonBlock;
     }
+    bool StreamSocketFsm::isConnecting(){
+        return fsmState == StrSoFsmState::CONNECTING;
+    }
     bool StreamSocketFsm::isConnected(){
         return StrSoFsmState::CONNECTED <= fsmState && fsmState < StrSoFsmState::CLOSED;
     }
@@ -203,6 +516,11 @@ namespace snl{
             throw SnlException("StreamSocket error: connect fail");
         }
     }
+    void StreamSocketFsm::connectFinishCheck(StrSoFsmState current){
+        if(current != StrSoFsmState::CONNECTING){
+            throw SnlException("StreamSocket error: connect finish fail, no connect in progress");
+        }
+    }
     void StreamSocketFsm::sendCheck(StrSoFsmState current){
         if(current != StrSoFsmState::CONNECTED && current != StrSoFsmState::DCLOSED){
             throw SnlException("StreamSocket error: Send fail");
@@ -1,6 +1,11 @@
 #ifndef STREAMSOCKETFSM_H
 #define STREAMSOCKETFSM_H
 
+#include <chrono>
+#include <span>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include "SocketAddress.h"
 #include "FdGuard.h"
 namespace snl{
@@ -13,6 +18,15 @@ namespace snl{
     struct StrSoClose {StrSoClose() = default; };
     struct StrSoReset {StrSoReset() = default; };
     struct StrSoReConnect {StrSoReConnect() = default; };
+    struct StrSoTrySend { StrSoTrySend() = default; };
+    struct StrSoTryReceive { StrSoTryReceive() = default; };
+    struct StrSoConnectStart { StrSoConnectStart() = default; };
+    struct StrSoConnectFinish { StrSoConnectFinish() = default; };
+    struct StrSoSendv { StrSoSendv() = default; };
+    struct StrSoReceivev { StrSoReceivev() = default; };
+    struct StrSoTrySendv { StrSoTrySendv() = default; };
+    struct StrSoSendFile { StrSoSendFile() = default; };
+    struct StrSoReceiveFile { StrSoReceiveFile() = default; };
     
     constexpr StrSoConnect connectAct{};
     constexpr StrSoSend sendAct{};
@@ -22,6 +36,15 @@ namespace snl{
     constexpr StrSoClose closeAct{};
     constexpr StrSoReset resetAct{};
     constexpr StrSoReConnect resetConnectAct{};
+    constexpr StrSoTrySend trySendAct{};
+    constexpr StrSoTryReceive tryReceiveAct{};
+    constexpr StrSoConnectStart connectStartAct{};
+    constexpr StrSoConnectFinish connectFinishAct{};
+    constexpr StrSoSendv sendvAct{};
+    constexpr StrSoReceivev receivevAct{};
+    constexpr StrSoTrySendv trySendvAct{};
+    constexpr StrSoSendFile sendFileAct{};
+    constexpr StrSoReceiveFile receiveFileAct{};
     
     
     
@@ -29,11 +52,18 @@ namespace snl{
     {
     public:
     
-        enum class StrSoFsmState:uint8_t {INIT = 0, CONNECTED = 1, UCLOSED = 2, DCLOSED = 3, CLOSED = 4};
+        enum class StrSoFsmState:uint8_t {INIT = 0, CONNECTING = 1, CONNECTED = 2, UCLOSED = 3, DCLOSED = 4, CLOSED = 5};
         StreamSocketFsm();
-        StreamSocketFsm(FdGuard&& fdGuard, SocketAddress address);
+        StreamSocketFsm(FdGuard&& fdGuard, SocketAddress address, bool nonBlockVal = defaultNonBlock); //nonBlockVal: the current behavior of the fd
+        StreamSocketFsm(FdGuard&& fdGuard, bool nonBlockVal); //connected socket, the peer address is fetched on first use
         
         ~StreamSocketFsm();
+        
+        //the state is allocated from the state pool (BufferPool::getStatePool): a thread local free list,
+        //so accepting or closing a connection takes no allocator lock
+        static void* operator new(std::size_t size);
+        static void operator delete(void* state, std::size_t size) noexcept;
+        
         template<typename Action, typename ...Args>
         void toNextState(Action& action, Args&&... args){
             toNextStateImpl(action, std::forward<Args>(args)...);
@@ -42,7 +72,9 @@ namespace snl{
         void setNonBlock(bool nonBlockVal);
         
         SocketAddress getSockAddress();
+        Fd getFd();
         bool isNonBlock();
+        bool isConnecting();
         bool isConnected();
         bool upstreamClosed();
         bool downStreamClosed();
@@ -51,14 +83,34 @@ namespace snl{
         static constexpr int upstreamShutdown = 1;
         static constexpr int downstreamShutdown = 0;
         static constexpr bool defaultNonBlock = false;
+        static constexpr std::chrono::milliseconds noTimeout{-1};
         
     private:
     
         
         
         void toNextStateImpl(const StrSoConnect&, const SocketAddress& socketAddress);
+        void toNextStateImpl(const StrSoConnect&, const SocketAddress& socketAddress, std::chrono::milliseconds timeout); //throws with ETIMEDOUT when the timeout expires
+        //happy eyeballs: starts a connect per candidate (in order) every attemptDelay until one completes
+        //the first connection to complete is kept, the other attempts are closed
+        void toNextStateImpl(const StrSoConnect&, const std::vector<SocketAddress>& candidates, std::chrono::milliseconds attemptDelay);
         void toNextStateImpl(const StrSoSend&, const void* buffer, std::size_t bufferSize, std::size_t& bytesSent, int flags); //sets the buffer size to the size of the unread portion
         void toNextStateImpl(const StrSoReceive&, void* buffer, std::size_t bufferSize, std::size_t& bytesReceived, int flags);
+        //non blocking variants of send and receive, wouldBlock is set instead of throwing on EAGAIN
+        void toNextStateImpl(const StrSoTrySend&, const void* buffer, std::size_t bufferSize, std::size_t& bytesSent, bool& wouldBlock, int flags);
+        void toNextStateImpl(const StrSoTryReceive&, void* buffer, std::size_t bufferSize, std::size_t& bytesReceived, bool& wouldBlock, int flags);
+        //scatter/gather variants, a single sendmsg/recvmsg over the segments (at most IOV_MAX of them per call)
+        void toNextStateImpl(const StrSoSendv&, std::span<const iovec> segments, std::size_t& bytesSent, int flags);
+        void toNextStateImpl(const StrSoReceivev&, std::span<const iovec> segments, std::size_t& bytesReceived, int flags);
+        void toNextStateImpl(const StrSoTrySendv&, std::span<const iovec> segments, std::size_t& bytesSent, bool& wouldBlock, int flags);
+        //file transfers without a user space buffer: sendfile from the file, splice through a pipe into the file
+        //the offset is advanced by the bytes transferred, wouldBlock is set instead of throwing on EAGAIN
+        void toNextStateImpl(const StrSoSendFile&, Fd fileFd, off_t& offset, std::size_t count, std::size_t& bytesSent, bool& wouldBlock);
+        void toNextStateImpl(const StrSoReceiveFile&, Fd fileFd, off_t& offset, std::size_t count, std::size_t& bytesReceived, bool& wouldBlock);
+        //two phase connect: the start never blocks, connected is true if the connection completed immediately
+        //the finish must be called once the socket is writable and checks the outcome of the connect
+        void toNextStateImpl(const StrSoConnectStart&, const SocketAddress& socketAddress, bool& connected);
+        void toNextStateImpl(const StrSoConnectFinish&);
         void toNextStateImpl(const StrSoUClose&);
         void toNextStateImpl(const StrSoDClose&);
         void toNextStateImpl(const StrSoClose&);
@@ -66,6 +118,7 @@ namespace snl{
         void toNextStateImpl(const StrSoReConnect&);
         
         static void connectCheck(StrSoFsmState current);
+        static void connectFinishCheck(StrSoFsmState current);
         static void sendCheck(StrSoFsmState current);
         static void receiveCheck(StrSoFsmState current);
         static void upstreamCloseCheck(StrSoFsmState current);
@@ -76,7 +129,23 @@ namespace snl{
         //creates a socket fd and connects it to the specified address
         //common call for reset connection and connect, the non block val is to indicate if the socket is blocking or not
         //-->saved blocking behavior will also be set here
-        static FdGuard createSockAndConnect(const SocketAddress& address, bool nonBlockVal);
+        //the connect never blocks longer than the timeout (noTimeout waits until the kernel gives up)
+        static FdGuard createSockAndConnect(const SocketAddress& address, bool nonBlockVal, std::chrono::milliseconds timeout = noTimeout);
+        
+        //creates a non blocking socket fd and starts the connect, connected is true if it completed immediately
+        static FdGuard createSockAndStartConnect(const SocketAddress& address, bool& connected);
+        
+        //waits until the connect in progress completes, throws if it failed or the timeout expired
+        static void waitConnected(FdGuard& guard, std::chrono::milliseconds timeout);
+        
+        //returns the pending error of the socket (SO_ERROR), 0 if the connect succeeded
+        static int getConnectError(FdGuard& guard);
+        
+        //message header over the segments, the count is capped at IOV_MAX (the rest is left for the next call)
+        static msghdr makeMessage(std::span<const iovec> segments);
+        
+        //creates the pipe used by the file receive on first use
+        void ensureSplicePipe();
         
         //setter for the blocking behavior of the blocking call
         //if nonBlockVal == true, the fd will be set to nonblock
@@ -84,7 +153,11 @@ namespace snl{
         
         
         SocketAddress socketAddress;
+        bool addressKnown = true; //false until the peer address of a lazily constructed socket is fetched
         FdGuard strSoFd;
+        FdGuard spliceRead; //pipe between the socket and the file for receiveToFile, empty between the calls
+        FdGuard spliceWrite;
+        std::size_t spliceCapacity = 0;
         bool nonBlock = defaultNonBlock;
         StrSoFsmState fsmState;
         
@@ -0,0 +1,145 @@
+#ifndef TASK_H
+#define TASK_H
+//c headers
+//cpp headers
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+//own headers
+
+namespace snl{
+
+    template<typename T>
+    class Task;
+
+    namespace detail{
+
+        //state shared by the promises of every task type
+        class TaskPromiseBase{
+        public:
+
+            //resumes the awaiting coroutine when the task completes (symmetric transfer, no stack growth)
+            struct FinalAwaiter{
+                bool await_ready() const noexcept { return false; }
+
+                template<typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept{
+                    TaskPromiseBase& promise = finished.promise();
+                    std::coroutine_handle<> continuation = promise.continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept { }
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+            void setContinuation(std::coroutine_handle<> awaiting) noexcept { continuation = awaiting; }
+
+        protected:
+            void rethrowIfFailed(){
+                if(exception){
+                    std::rethrow_exception(exception);
+                }
+            }
+
+        private:
+            std::coroutine_handle<> continuation;
+            std::exception_ptr exception;
+        };
+
+        template<typename T>
+        class TaskPromise : public TaskPromiseBase{
+        public:
+            Task<T> get_return_object() noexcept;
+
+            template<typename U>
+            void return_value(U&& value){ result.emplace(std::forward<U>(value)); }
+
+            T takeResult(){
+                rethrowIfFailed();
+                return std::move(*result);
+            }
+
+        private:
+            std::optional<T> result;
+        };
+
+        template<>
+        class TaskPromise<void> : public TaskPromiseBase{
+        public:
+            Task<void> get_return_object() noexcept;
+
+            void return_void() const noexcept { }
+
+            void takeResult(){ rethrowIfFailed(); }
+        };
+    }
+
+    /**
+     * Lazily started coroutine producing a value of type T
+     * the task starts running when it is awaited and resumes its awaiter when it completes,
+     * exceptions thrown inside the task are rethrown at the co_await
+     */
+    template<typename T = void>
+    class Task
+    {
+    public:
+
+        using promise_type = detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() noexcept = default;
+        explicit Task(Handle handle_) noexcept : handle(handle_) { }
+        Task(Task&& rhs) noexcept : handle(std::exchange(rhs.handle, nullptr)) { }
+        Task& operator=(Task&& rhs) noexcept{
+            if(this != &rhs){
+                destroy();
+                handle = std::exchange(rhs.handle, nullptr);
+            }
+            return *this;
+        }
+        ~Task(){ destroy(); }
+
+        Task(const Task& rhs) = delete;
+        Task& operator=(const Task& rhs) = delete;
+
+        bool await_ready() const noexcept { return !handle || handle.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept{
+            handle.promise().setContinuation(awaiting);
+            return handle; //start the task on the current thread
+        }
+
+        T await_resume(){ return handle.promise().takeResult(); }
+
+        bool isDone() const noexcept { return !handle || handle.done(); }
+
+    private:
+
+        void destroy() noexcept{
+            if(handle){
+                handle.destroy();
+                handle = nullptr;
+            }
+        }
+
+        Handle handle;
+    };
+
+    namespace detail{
+        template<typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept{
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept{
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+    }
+}
+
+#endif // TASK_H
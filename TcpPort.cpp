@@ -37,8 +37,6 @@ namespace snl{
 //        return converted;
 //    }
     
-    TcpPort::~TcpPort() = default;
-    
     /*
      * member functions
      */ 
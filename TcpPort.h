@@ -25,7 +25,7 @@ namespace snl{
         TcpPort& operator= (const TcpPort& rhs) noexcept = default;
         TcpPort& operator= (TcpPort&& rhs) noexcept = default;
         
-        ~TcpPort();
+        ~TcpPort() = default;
         
         TcpPortNbType toNetworkByteOrder();
         TcpPortNbType getPortNumber();
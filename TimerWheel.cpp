@@ -0,0 +1,197 @@
+#include "TimerWheel.h"
+//c headers
+//cpp headers
+#include <bit>
+#include <utility>
+//own headers
+
+namespace snl{
+
+    TimerWheel::TimerWheel(std::chrono::milliseconds resolution_, TimePoint start_) :
+        start(start_), resolution(std::chrono::duration_cast<Clock::duration>(resolution_)){
+        slots.fill(noNode);
+    }
+
+    TimerWheel::TimerId TimerWheel::add(TimePoint deadline, Callback callback){
+        std::uint32_t nodeIndex = freeHead;
+        if(nodeIndex == noNode){
+            nodes.emplace_back();
+            nodeIndex = static_cast<std::uint32_t>(nodes.size() - 1);
+        }else{
+            freeHead = nodes[nodeIndex].next;
+        }
+
+        Node& node = nodes[nodeIndex];
+        //round up, the timer must not fire before the deadline
+        std::uint64_t expiry = 0;
+        if(deadline > start){
+            expiry = static_cast<std::uint64_t>((deadline - start + resolution - Clock::duration(1)) / resolution);
+        }
+        node.expiry = expiry;
+        node.callback = std::move(callback);
+        link(nodeIndex);
+        timerCount++;
+
+        return (static_cast<TimerId>(node.generation) << 32) | nodeIndex;
+    }
+
+    bool TimerWheel::cancel(TimerId timerId) noexcept{
+        std::uint32_t nodeIndex = static_cast<std::uint32_t>(timerId);
+        std::uint32_t generation = static_cast<std::uint32_t>(timerId >> 32);
+        if(nodeIndex >= nodes.size() || nodes[nodeIndex].generation != generation || nodes[nodeIndex].slot == noNode){
+            return false;
+        }
+
+        unlink(nodeIndex);
+        release(nodeIndex);
+        timerCount--;
+        return true;
+    }
+
+    std::size_t TimerWheel::advance(TimePoint now){
+        std::uint64_t target = toTick(now);
+        std::size_t fired = 0;
+        while(currentTick <= target){
+            if(timerCount == 0){
+                currentTick = target + 1; //nothing to cascade or fire, skip the idle ticks
+                break;
+            }
+            fired += processTick();
+        }
+        return fired;
+    }
+
+    std::optional<TimerWheel::TimePoint> TimerWheel::nextWakeup() const noexcept{
+        if(timerCount == 0){
+            return std::nullopt;
+        }
+
+        //first non empty level 0 slot from the current position, else the next cascade (wrap of level 0)
+        //note: at index 0 the cascade is part of the current tick
+        std::size_t index = currentTick & (slotsPerLevel - 1);
+        std::uint64_t ticks = (slotsPerLevel - index) & (slotsPerLevel - 1);
+        for(std::size_t word = index / 64; word != lowestOccupied.size(); word++){
+            std::uint64_t bits = lowestOccupied[word];
+            if(word == index / 64){
+                bits &= ~std::uint64_t{0} << (index % 64);
+            }
+            if(bits != 0){
+                ticks = word * 64 + static_cast<std::size_t>(std::countr_zero(bits)) - index;
+                break;
+            }
+        }
+
+        return start + resolution * static_cast<Clock::rep>(currentTick + ticks);
+    }
+
+    std::size_t TimerWheel::getTimerCount() const noexcept{
+        return timerCount;
+    }
+
+    void TimerWheel::link(std::uint32_t nodeIndex){
+        Node& node = nodes[nodeIndex];
+        if(node.expiry < currentTick){
+            node.expiry = currentTick; //overdue, fire on the next tick processed
+        }
+
+        //the level is chosen by the distance to the deadline, the slot by the matching bits of the deadline
+        std::uint64_t delta = node.expiry - currentTick;
+        std::uint64_t position = node.expiry;
+        std::size_t level = 0;
+        while(level != nbLevels - 1 && delta >= (std::uint64_t{1} << (levelBits * (level + 1)))){
+            level++;
+        }
+        if(delta >= (std::uint64_t{1} << (levelBits * nbLevels))){
+            //beyond the range of the wheel, park it in the furthest slot, it is cascaded again later
+            position = currentTick + (std::uint64_t{1} << (levelBits * nbLevels)) - 1;
+        }
+
+        std::size_t slotIndex = (position >> (levelBits * level)) & (slotsPerLevel - 1);
+        std::uint32_t slot = static_cast<std::uint32_t>(level * slotsPerLevel + slotIndex);
+
+        node.slot = slot;
+        node.prev = noNode;
+        node.next = slots[slot];
+        if(node.next != noNode){
+            nodes[node.next].prev = nodeIndex;
+        }
+        slots[slot] = nodeIndex;
+
+        if(level == 0){
+            lowestOccupied[slotIndex / 64] |= std::uint64_t{1} << (slotIndex % 64);
+        }
+    }
+
+    void TimerWheel::unlink(std::uint32_t nodeIndex) noexcept{
+        Node& node = nodes[nodeIndex];
+        if(node.prev != noNode){
+            nodes[node.prev].next = node.next;
+        }else{
+            slots[node.slot] = node.next;
+        }
+        if(node.next != noNode){
+            nodes[node.next].prev = node.prev;
+        }
+
+        if(node.slot < slotsPerLevel && slots[node.slot] == noNode){
+            lowestOccupied[node.slot / 64] &= ~(std::uint64_t{1} << (node.slot % 64));
+        }
+        node.prev = noNode;
+        node.next = noNode;
+    }
+
+    void TimerWheel::release(std::uint32_t nodeIndex) noexcept{
+        Node& node = nodes[nodeIndex];
+        node.callback = nullptr;
+        node.slot = noNode;
+        //invalidate the outstanding ids of the node, 0 is skipped so no id equals invalidTimer
+        node.generation = node.generation == UINT32_MAX ? 1 : node.generation + 1;
+        node.next = freeHead;
+        freeHead = nodeIndex;
+    }
+
+    std::size_t TimerWheel::cascade(std::size_t level){
+        std::size_t slotIndex = (currentTick >> (levelBits * level)) & (slotsPerLevel - 1);
+        std::uint32_t slot = static_cast<std::uint32_t>(level * slotsPerLevel + slotIndex);
+
+        std::uint32_t nodeIndex = slots[slot];
+        slots[slot] = noNode;
+        while(nodeIndex != noNode){
+            std::uint32_t next = nodes[nodeIndex].next;
+            link(nodeIndex);
+            nodeIndex = next;
+        }
+        return slotIndex;
+    }
+
+    std::size_t TimerWheel::processTick(){
+        std::size_t index = currentTick & (slotsPerLevel - 1);
+        //at every wrap of a level the matching slot of the level above is redistributed
+        for(std::size_t level = 1; index == 0 && level != nbLevels; level++){
+            if(cascade(level) != 0){
+                break;
+            }
+        }
+
+        std::size_t fired = 0;
+        while(slots[index] != noNode){
+            std::uint32_t nodeIndex = slots[index];
+            unlink(nodeIndex);
+            Callback callback = std::move(nodes[nodeIndex].callback);
+            release(nodeIndex); //the timer is done before the callback runs, cancelling it from there is a no op
+            timerCount--;
+            fired++;
+            callback();
+        }
+
+        currentTick++;
+        return fired;
+    }
+
+    std::uint64_t TimerWheel::toTick(TimePoint timePoint) const noexcept{
+        if(timePoint <= start){
+            return 0;
+        }
+        return static_cast<std::uint64_t>((timePoint - start) / resolution);
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+//c headers
+//cpp headers
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+//own headers
+
+namespace snl{
+
+    /**
+     * Hierarchical timer wheel (4 levels of 256 slots)
+     * adding and cancelling a timer is O(1), timers far in the future are cascaded to the lower levels
+     * as time advances. Time is kept in ticks of the resolution, a timer never fires before its deadline
+     * but may fire up to one resolution later.
+     * note: not thread safe, meant to be driven by a single event loop
+     */
+    class TimerWheel
+    {
+    public:
+
+        using Clock = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+        using TimerId = std::uint64_t; //slot index and generation, stale ids are detected on cancel
+        using Callback = std::function<void()>;
+
+        explicit TimerWheel(std::chrono::milliseconds resolution = defaultResolution, TimePoint start = Clock::now());
+
+        TimerWheel(const TimerWheel& rhs) = delete;
+        TimerWheel& operator=(const TimerWheel& rhs) = delete;
+
+        /**
+         * @brief schedules the callback to run once the deadline has passed
+         * @return the id of the timer, never equal to invalidTimer
+         * note: deadlines in the past fire on the next call to advance
+         */
+        TimerId add(TimePoint deadline, Callback callback);
+
+        /**
+         * @brief cancels a pending timer
+         * @return false if the timer already fired or was cancelled before
+         */
+        bool cancel(TimerId timerId) noexcept;
+
+        /**
+         * @brief fires every timer with a deadline up to now
+         * @return the number of timers fired
+         * note: callbacks may add and cancel timers
+         */
+        std::size_t advance(TimePoint now);
+
+        /**
+         * @brief the time at which advance must be called next, empty if there are no timers
+         * note: may be earlier than the first deadline when timers of the upper levels must be cascaded
+         */
+        std::optional<TimePoint> nextWakeup() const noexcept;
+
+        std::size_t getTimerCount() const noexcept;
+
+        static constexpr std::chrono::milliseconds defaultResolution{10};
+        static constexpr TimerId invalidTimer = 0;
+
+    private:
+
+        static constexpr std::size_t levelBits = 8;
+        static constexpr std::size_t slotsPerLevel = std::size_t{1} << levelBits;
+        static constexpr std::size_t nbLevels = 4;
+        static constexpr std::uint32_t noNode = UINT32_MAX;
+
+        //timers are kept in intrusive doubly linked lists per slot (indices into the node vector)
+        struct Node{
+            std::uint64_t expiry = 0; //in ticks
+            Callback callback;
+            std::uint32_t prev = noNode;
+            std::uint32_t next = noNode;
+            std::uint32_t slot = noNode; //noNode if the node is free
+            std::uint32_t generation = 1;
+        };
+
+        void link(std::uint32_t nodeIndex);
+        void unlink(std::uint32_t nodeIndex) noexcept;
+        void release(std::uint32_t nodeIndex) noexcept;
+        //moves the timers of the slot of a higher level down to the levels they now belong to
+        //returns the index of the slot (0 means the level below wrapped as well)
+        std::size_t cascade(std::size_t level);
+        std::size_t processTick();
+
+        std::uint64_t toTick(TimePoint timePoint) const noexcept;
+
+        TimePoint start;
+        Clock::duration resolution;
+        std::uint64_t currentTick = 0; //the next tick to process
+        std::size_t timerCount = 0;
+
+        std::vector<Node> nodes;
+        std::uint32_t freeHead = noNode;
+        std::array<std::uint32_t, nbLevels * slotsPerLevel> slots;
+        std::array<std::uint64_t, slotsPerLevel / 64> lowestOccupied{}; //bitmap of the non empty level 0 slots
+    };
+}
+
+#endif // TIMERWHEEL_H
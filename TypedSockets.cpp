@@ -0,0 +1,158 @@
+#include "TypedSockets.h"
+//c headers
+#include <cerrno>
+#include <climits>
+#include <sys/socket.h>
+//cpp headers
+#include <algorithm>
+//own headers
+#include "SnlException.h"
+#include "StreamSocket.h"
+#include "TcpPort.h"
+
+namespace snl{
+
+    //same end of stream detection as the runtime fsm: 0 bytes for a non empty request is the end
+    static std::size_t receiveChecked(Fd fd, void* buffer, std::size_t bufferSize, int flags){
+        int failure = -1;
+        std::size_t bytesReceived = executeSyscall(::recv, failure, fd, buffer, bufferSize, flags);
+        if(bytesReceived == 0 && bufferSize != 0){
+            throw SnlEofException("End of file reached");
+        }
+        return bytesReceived;
+    }
+
+    static msghdr makeMessage(std::span<const iovec> segments){
+        msghdr message{};
+        //the kernel only reads the segments, the cast is needed because msghdr is used for both directions
+        message.msg_iov = const_cast<iovec*>(segments.data());
+        message.msg_iovlen = std::min<std::size_t>(segments.size(), IOV_MAX);
+        return message;
+    }
+
+    static std::size_t receivevChecked(Fd fd, std::span<const iovec> segments, int flags){
+        int failure = -1;
+        msghdr message = makeMessage(segments);
+        std::size_t bytesReceived = executeSyscall(::recvmsg, failure, fd, &message, flags);
+        if(bytesReceived == 0){
+            for(const iovec& segment : segments.first(message.msg_iovlen)){
+                if(segment.iov_len != 0){
+                    throw SnlEofException("End of file reached");
+                }
+            }
+        }
+        return bytesReceived;
+    }
+
+    /*
+     * server states
+     */
+
+    void UnboundServer::setReusePort(bool reusePortVal) noexcept{ reusePort = reusePortVal; }
+
+    BoundServer UnboundServer::bind(const SocketAddress& sockAddr) &&{
+        FdGuard guard = makeFdGuard(::socket, sockAddr.getAddressFamily(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int failure = -1;
+        if(reusePort){
+            int enable = 1;
+            executeSyscall(::setsockopt, failure, guard.get(), SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+        }
+        executeSyscall(::bind, failure, guard.get(), sockAddr.getSockaddr(), sockAddr.getAddrlen());
+
+        //if the port was left to the kernel, keep the port it picked
+        if(sockAddr.getTcpPort().getPortNumber() == 0){
+            sockaddr_storage storage{};
+            socklen_t addrlen = sizeof(sockaddr_storage);
+            executeSyscall(::getsockname, failure, guard.get(), reinterpret_cast<sockaddr*>(&storage), &addrlen);
+            return BoundServer(std::move(guard), makeSockAddr(storage));
+        }
+        return BoundServer(std::move(guard), sockAddr);
+    }
+
+    BoundServer::BoundServer(FdGuard&& guard, const SocketAddress& sockAddr_) noexcept : servSockFd(std::move(guard)), sockAddr(sockAddr_) { }
+
+    ListeningServer BoundServer::listen(int backlog) &&{
+        int failure = -1;
+        executeSyscall(::listen, failure, servSockFd.get(), backlog);
+        return ListeningServer(std::move(servSockFd), sockAddr);
+    }
+
+    const SocketAddress& BoundServer::getSockAddr() const noexcept{ return sockAddr; }
+
+    Fd BoundServer::getFd() const noexcept{ return servSockFd.get(); }
+
+    ListeningServer::ListeningServer(FdGuard&& guard, const SocketAddress& sockAddr_) noexcept : servSockFd(std::move(guard)), sockAddr(sockAddr_) { }
+
+    ConnectedStream ListeningServer::accept(){
+        sockaddr_storage clientSockaddr{};
+        socklen_t clientAddrlen = sizeof(sockaddr_storage);
+        int failure = -1;
+        Fd clientFd = executeSyscall(::accept4, failure, servSockFd.get(), reinterpret_cast<sockaddr*>(&clientSockaddr), &clientAddrlen, SOCK_CLOEXEC);
+        FdGuard guard(clientFd);
+        return ConnectedStream(std::move(guard), makeSockAddr(clientSockaddr));
+    }
+
+    const SocketAddress& ListeningServer::getSockAddr() const noexcept{ return sockAddr; }
+
+    Fd ListeningServer::getFd() const noexcept{ return servSockFd.get(); }
+
+    /*
+     * stream states
+     */
+
+    ConnectedStream::ConnectedStream(FdGuard&& guard, const SocketAddress& sockAddr_) noexcept : strSoFd(std::move(guard)), sockAddr(sockAddr_) { }
+
+    ConnectedStream ConnectedStream::connect(const SocketAddress& sockAddr){
+        FdGuard guard = makeFdGuard(::socket, sockAddr.getAddressFamily(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int failure = -1;
+        executeSyscall(::connect, failure, guard.get(), sockAddr.getSockaddr(), sockAddr.getAddrlen());
+        return ConnectedStream(std::move(guard), sockAddr);
+    }
+
+    std::size_t ConnectedStream::send(const void* buffer, std::size_t bufferSize, int flags){
+        int failure = -1;
+        return executeSyscall(::send, failure, strSoFd.get(), buffer, bufferSize, flags);
+    }
+
+    std::size_t ConnectedStream::receive(void* buffer, std::size_t bufferSize, int flags){
+        return receiveChecked(strSoFd.get(), buffer, bufferSize, flags);
+    }
+
+    std::size_t ConnectedStream::sendv(std::span<const iovec> segments, int flags){
+        int failure = -1;
+        msghdr message = makeMessage(segments);
+        return executeSyscall(::sendmsg, failure, strSoFd.get(), &message, flags);
+    }
+
+    std::size_t ConnectedStream::receivev(std::span<const iovec> segments, int flags){
+        return receivevChecked(strSoFd.get(), segments, flags);
+    }
+
+    UpClosedStream ConnectedStream::closeUpstream() &&{
+        int failure = -1;
+        executeSyscall(::shutdown, failure, strSoFd.get(), SHUT_WR);
+        return UpClosedStream(std::move(strSoFd), sockAddr);
+    }
+
+    StreamSocket ConnectedStream::toStreamSocket() &&{
+        return StreamSocket(std::move(strSoFd), sockAddr);
+    }
+
+    const SocketAddress& ConnectedStream::getSocketAddress() const noexcept{ return sockAddr; }
+
+    Fd ConnectedStream::getFd() const noexcept{ return strSoFd.get(); }
+
+    UpClosedStream::UpClosedStream(FdGuard&& guard, const SocketAddress& sockAddr_) noexcept : strSoFd(std::move(guard)), sockAddr(sockAddr_) { }
+
+    std::size_t UpClosedStream::receive(void* buffer, std::size_t bufferSize, int flags){
+        return receiveChecked(strSoFd.get(), buffer, bufferSize, flags);
+    }
+
+    std::size_t UpClosedStream::receivev(std::span<const iovec> segments, int flags){
+        return receivevChecked(strSoFd.get(), segments, flags);
+    }
+
+    const SocketAddress& UpClosedStream::getSocketAddress() const noexcept{ return sockAddr; }
+
+    Fd UpClosedStream::getFd() const noexcept{ return strSoFd.get(); }
+}
@@ -0,0 +1,177 @@
+#ifndef TYPEDSOCKETS_H
+#define TYPEDSOCKETS_H
+//c headers
+#include <sys/uio.h>
+//cpp headers
+#include <span>
+//own headers
+#include "FdGuard.h"
+#include "SocketAddress.h"
+
+namespace snl{
+
+    //forward declarations
+    class StreamSocket;
+    class BoundServer;
+    class ListeningServer;
+    class ConnectedStream;
+    class UpClosedStream;
+
+    /*
+     * Typestate api for the socket state machines
+     * every state of the fsm is its own type and a transition consumes the old state (the transitions are
+     * rvalue qualified) and returns the new one: calling listen on an unbound server or sending on an
+     * upstream closed stream does not compile. The checks of the runtime fsm (sendCheck, receiveCheck, ...)
+     * are therefore not needed, the calls go straight to the system call.
+     *     ListeningServer server = UnboundServer().bind(sockAddr).listen();
+     *     ConnectedStream client = server.accept();
+     *     client.send(buffer, bufferSize);
+     *     UpClosedStream draining = std::move(client).closeUpstream();
+     * note: a moved from state owns no fd, using it is not caught at compile time
+     * note: ServerSocket and StreamSocket remain for dynamic use, a connected stream can be handed over
+     *       to a StreamSocket (toStreamSocket), e.g. to add it to an EventLoop
+     */
+
+    /**
+     * server socket before the bind, no fd yet
+     */
+    class UnboundServer
+    {
+    public:
+
+        UnboundServer() noexcept = default;
+
+        void setReusePort(bool reusePortVal) noexcept; //SO_REUSEPORT, applied by the bind
+
+        /**
+         * @brief creates the socket and binds it to the address
+         * @throws SnlException if the socket could not be created or bound
+         */
+        BoundServer bind(const SocketAddress& sockAddr) &&;
+
+    private:
+
+        bool reusePort = false;
+    };
+
+    /**
+     * bound server socket, not listening yet
+     */
+    class BoundServer
+    {
+    public:
+
+        static constexpr int defaultBacklog = 5;
+
+        /**
+         * @throws SnlException if the listen fails
+         */
+        ListeningServer listen(int backlog = defaultBacklog) &&;
+
+        const SocketAddress& getSockAddr() const noexcept; //the port picked by the kernel if it was bound to port 0
+        Fd getFd() const noexcept;
+
+    private:
+
+        friend class UnboundServer;
+
+        BoundServer(FdGuard&& guard, const SocketAddress& sockAddr) noexcept;
+
+        FdGuard servSockFd;
+        SocketAddress sockAddr;
+    };
+
+    /**
+     * listening server socket, the socket is closed when the object is destroyed
+     */
+    class ListeningServer
+    {
+    public:
+
+        /**
+         * @brief accepts a single client, blocks until one is there
+         * @throws SnlException if the accept fails
+         */
+        ConnectedStream accept();
+
+        const SocketAddress& getSockAddr() const noexcept;
+        Fd getFd() const noexcept;
+
+    private:
+
+        friend class BoundServer;
+
+        ListeningServer(FdGuard&& guard, const SocketAddress& sockAddr) noexcept;
+
+        FdGuard servSockFd;
+        SocketAddress sockAddr;
+    };
+
+    /**
+     * connected stream, both directions open
+     * the send and receive calls have the semantics of the StreamSocket calls (blocking unless a flag says
+     * otherwise, an SnlEofException at the end of the stream) without the state checks
+     */
+    class ConnectedStream
+    {
+    public:
+
+        /**
+         * @brief connects a new stream to the address (blocking)
+         * @throws SnlException if the connect fails
+         */
+        static ConnectedStream connect(const SocketAddress& sockAddr);
+
+        std::size_t send(const void* buffer, std::size_t bufferSize, int flags = 0);
+        std::size_t receive(void* buffer, std::size_t bufferSize, int flags = 0);
+        std::size_t sendv(std::span<const iovec> segments, int flags = 0);
+        std::size_t receivev(std::span<const iovec> segments, int flags = 0);
+
+        /**
+         * @brief shuts the sending direction down, the peer sees the end of the stream
+         */
+        UpClosedStream closeUpstream() &&;
+
+        /**
+         * @brief hands the connection over to a runtime checked StreamSocket
+         */
+        StreamSocket toStreamSocket() &&;
+
+        const SocketAddress& getSocketAddress() const noexcept;
+        Fd getFd() const noexcept;
+
+    private:
+
+        friend class ListeningServer;
+
+        ConnectedStream(FdGuard&& guard, const SocketAddress& sockAddr) noexcept;
+
+        FdGuard strSoFd;
+        SocketAddress sockAddr;
+    };
+
+    /**
+     * stream whose sending direction is shut down, it can only receive the rest of the peer's data
+     */
+    class UpClosedStream
+    {
+    public:
+
+        std::size_t receive(void* buffer, std::size_t bufferSize, int flags = 0);
+        std::size_t receivev(std::span<const iovec> segments, int flags = 0);
+
+        const SocketAddress& getSocketAddress() const noexcept;
+        Fd getFd() const noexcept;
+
+    private:
+
+        friend class ConnectedStream;
+
+        UpClosedStream(FdGuard&& guard, const SocketAddress& sockAddr) noexcept;
+
+        FdGuard strSoFd;
+        SocketAddress sockAddr;
+    };
+}
+
+#endif // TYPEDSOCKETS_H
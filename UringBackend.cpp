@@ -0,0 +1,671 @@
+#include "UringBackend.h"
+//c headers
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+//cpp headers
+#include <algorithm>
+#include <cassert>
+//own headers
+#include "ServerSocket.h"
+#include "StreamSocket.h"
+#include "SocketAddress.h"
+#include "SnlException.h"
+
+namespace snl{
+
+    /*
+     * raw io_uring syscalls (glibc does not provide wrappers)
+     */
+
+    static int ioUringSetup(unsigned entries, io_uring_params* params){
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    static int ioUringEnter(Fd ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags){
+        return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+    }
+
+    static int ioUringRegister(Fd ringFd, unsigned opcode, const void* arg, unsigned nbArgs){
+        return static_cast<int>(::syscall(__NR_io_uring_register, ringFd, opcode, arg, nbArgs));
+    }
+
+    static std::error_code makeErrorCode(int errorNo){
+        return std::error_code(errorNo, std::generic_category());
+    }
+
+    struct UringBackend::Ring{
+        Ring(Fd fd, const io_uring_params& params);
+        ~Ring();
+
+        //the number of prepared entries the kernel did not consume yet
+        unsigned pending() const noexcept { return localTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE); }
+        bool isFull() const noexcept { return pending() == *sqEntries; }
+
+        FdGuard ringFd;
+
+        void* sqPtr = MAP_FAILED;
+        std::size_t sqSize = 0;
+        void* cqPtr = MAP_FAILED;
+        std::size_t cqSize = 0;
+        io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        std::size_t sqesSize = 0;
+
+        //submission queue
+        unsigned* sqHead = nullptr;
+        unsigned* sqTail = nullptr;
+        unsigned* sqMask = nullptr;
+        unsigned* sqEntries = nullptr;
+        unsigned* sqArray = nullptr;
+        unsigned localTail = 0;
+        unsigned toSubmit = 0; //entries prepared since the last io_uring_enter
+
+        //completion queue
+        unsigned* cqHead = nullptr;
+        unsigned* cqTail = nullptr;
+        unsigned* cqMask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+    };
+
+    UringBackend::Ring::Ring(Fd fd, const io_uring_params& params) : ringFd(fd){
+        sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if(singleMmap){
+            sqSize = cqSize = std::max(sqSize, cqSize);
+        }
+
+        sqPtr = ::mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if(sqPtr == MAP_FAILED){
+            throw SnlException("UringBackend error: ", errno);
+        }
+
+        if(singleMmap){
+            cqPtr = sqPtr;
+        }else{
+            cqPtr = ::mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if(cqPtr == MAP_FAILED){
+                int errorNo = errno;
+                ::munmap(sqPtr, sqSize);
+                throw SnlException("UringBackend error: ", errorNo);
+            }
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqesPtr = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if(sqesPtr == MAP_FAILED){
+            int errorNo = errno;
+            if(!singleMmap){
+                ::munmap(cqPtr, cqSize);
+            }
+            ::munmap(sqPtr, sqSize);
+            throw SnlException("UringBackend error: ", errorNo);
+        }
+        sqes = static_cast<io_uring_sqe*>(sqesPtr);
+
+        char* sq = static_cast<char*>(sqPtr);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqEntries = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        localTail = *sqTail;
+
+        char* cq = static_cast<char*>(cqPtr);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    UringBackend::Ring::~Ring(){
+        ::munmap(sqes, sqesSize);
+        if(cqPtr != sqPtr){
+            ::munmap(cqPtr, cqSize);
+        }
+        ::munmap(sqPtr, sqSize);
+        //the ring fd is closed by the guard, this cancels all the operations still in flight
+    }
+
+    struct UringBackend::Operation{
+        enum class Kind:uint8_t {SEND = 0, RECEIVE = 1, ACCEPT = 2, CONNECT = 3, CANCEL = 4};
+
+        Operation(Kind kind_) : kind(kind_) { }
+
+        Kind kind;
+        IoCallback ioCallback; //send & receive
+        SocketCallback socketCallback; //connect
+        AcceptQueue* acceptQueue = nullptr; //accept
+        bool multishot = false; //accept
+        FdGuard connectFd; //connect, the socket that is being connected
+        sockaddr_storage storage{}; //connect & single shot accept, the address must stay valid until the completion
+        socklen_t addrlen = sizeof(sockaddr_storage); //single shot accept, set by the kernel
+    };
+
+    struct UringBackend::AcceptQueue{
+        ServerSocket* server = nullptr;
+        Fd fd = -1;
+        bool armed = false; //an accept is in flight
+        bool cancelled = false; //no new accepts are armed
+        std::uint64_t userData = 0; //the user data of the accept in flight
+        //a connection accepted while no callback was waiting, the raw peer address if the accept returned it
+        struct Accepted{
+            FdGuard guard;
+            sockaddr_storage storage;
+            bool hasAddress;
+        };
+
+        std::deque<Accepted> ready;
+        std::deque<SocketCallback> waiting; //callbacks waiting for a connection
+    };
+
+    UringBackend::UringBackend(unsigned entries){
+        io_uring_params params{};
+        int ringFd = ioUringSetup(entries, &params);
+        if(ringFd == -1){
+            return; //no io_uring available (ENOSYS, EPERM, ...), use the syscall path
+        }
+
+        try{
+            ring = std::make_unique<Ring>(ringFd, params);
+        }catch(SnlException&){
+            //the ring could not be mapped, the guard inside the ring closed the fd already
+            return;
+        }
+        probeOps();
+    }
+
+    UringBackend::~UringBackend() = default;
+
+    void UringBackend::probeOps(){
+        constexpr unsigned maxProbeOps = 256;
+        std::vector<char> probeMem(sizeof(io_uring_probe) + maxProbeOps * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeMem.data());
+
+        supportedOps.assign(maxProbeOps, false);
+        if(ioUringRegister(ring->ringFd.get(), IORING_REGISTER_PROBE, probe, maxProbeOps) == -1){
+            return; //kernels without probing lack the socket opcodes anyway
+        }
+
+        for(unsigned i = 0; i != probe->ops_len && i != maxProbeOps; i++){
+            supportedOps[probe->ops[i].op] = probe->ops[i].flags & IO_URING_OP_SUPPORTED;
+        }
+    }
+
+    bool UringBackend::supportsOp(std::uint8_t opcode) const noexcept{
+        return ring && opcode < supportedOps.size() && supportedOps[opcode];
+    }
+
+    bool UringBackend::isUringEnabled() const noexcept{
+        return static_cast<bool>(ring);
+    }
+
+    UringBackend::Stats UringBackend::getStats() const noexcept{
+        return stats;
+    }
+
+    io_uring_sqe* UringBackend::prepare(std::uint8_t opcode, Fd fd, std::unique_ptr<Operation> operation){
+        assert(ring);
+        while(ring->isFull()){
+            if(ring->toSubmit == 0){
+                throw SnlException("UringBackend error: submission queue full");
+            }
+            if(flush() != 0){
+                continue;
+            }
+            //the kernel refuses new entries while the completion queue overflows (EBUSY), reaping the
+            //completions makes room, without any completion to reap the next flush would not progress either
+            if(reap() == 0){
+                throw SnlException("UringBackend error: submission queue full and no completions to reap");
+            }
+        }
+
+        unsigned index = ring->localTail & *ring->sqMask;
+        io_uring_sqe* sqe = &ring->sqes[index];
+        std::memset(sqe, 0, sizeof(io_uring_sqe));
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->user_data = nextUserData++;
+
+        ring->sqArray[index] = index;
+        ring->localTail++;
+        //publish the entry, the kernel reads the tail with acquire semantics
+        __atomic_store_n(ring->sqTail, ring->localTail, __ATOMIC_RELEASE);
+        ring->toSubmit++;
+
+        inFlight.emplace(sqe->user_data, std::move(operation));
+        return sqe;
+    }
+
+    /*
+     * submissions
+     */
+
+    void UringBackend::submit(const StrSoSend&, StreamSocket& strSock, const void* buffer, std::size_t bufferSize, int flags, IoCallback callback){
+        if(!strSock.isConnected() || strSock.upstreamClosed()){
+            throw SnlException("UringBackend error: trying to send with a socket that is not connected");
+        }
+
+        if(!supportsOp(IORING_OP_SEND)){
+            stats.fallbackOps++;
+            deferred.push_back([&strSock, buffer, bufferSize, flags, callback = std::move(callback)](){
+                std::size_t bytesSent = 0;
+                std::error_code error;
+                try{
+                    bytesSent = strSock.send(buffer, bufferSize, flags);
+                }catch(SnlException& e){
+                    error = e.getErrorCode();
+                }
+                callback(bytesSent, error);
+            });
+            return;
+        }
+
+        auto operation = std::make_unique<Operation>(Operation::Kind::SEND);
+        operation->ioCallback = std::move(callback);
+        io_uring_sqe* sqe = prepare(IORING_OP_SEND, strSock.getFd(), std::move(operation));
+        sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe->len = static_cast<std::uint32_t>(bufferSize);
+        sqe->msg_flags = static_cast<std::uint32_t>(flags);
+    }
+
+    void UringBackend::submit(const StrSoReceive&, StreamSocket& strSock, void* buffer, std::size_t bufferSize, int flags, IoCallback callback){
+        if(!strSock.isConnected() || strSock.downStreamClosed()){
+            throw SnlException("UringBackend error: trying to receive with a socket that is not connected");
+        }
+
+        if(!supportsOp(IORING_OP_RECV)){
+            stats.fallbackOps++;
+            deferred.push_back([&strSock, buffer, bufferSize, flags, callback = std::move(callback)](){
+                std::size_t bytesReceived = 0;
+                std::error_code error;
+                try{
+                    bytesReceived = strSock.receive(buffer, bufferSize, flags);
+                }catch(SnlEofException&){
+                    //reported as a receive of 0 bytes, like the kernel does
+                }catch(SnlException& e){
+                    error = e.getErrorCode();
+                }
+                callback(bytesReceived, error);
+            });
+            return;
+        }
+
+        auto operation = std::make_unique<Operation>(Operation::Kind::RECEIVE);
+        operation->ioCallback = std::move(callback);
+        io_uring_sqe* sqe = prepare(IORING_OP_RECV, strSock.getFd(), std::move(operation));
+        sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe->len = static_cast<std::uint32_t>(bufferSize);
+        sqe->msg_flags = static_cast<std::uint32_t>(flags);
+    }
+
+    void UringBackend::submit(const ServerAccept&, ServerSocket& servSock, SocketCallback callback){
+        if(!servSock.isListening()){
+            throw SnlException("UringBackend error: trying to accept with socket that is not listening");
+        }
+
+        if(!supportsOp(IORING_OP_ACCEPT)){
+            stats.fallbackOps++;
+            deferred.push_back([&servSock, callback = std::move(callback)](){
+                try{
+                    callback(servSock.accept(), std::error_code());
+                }catch(SnlException& e){
+                    callback(StreamSocket(), e.getErrorCode());
+                }
+            });
+            return;
+        }
+
+        std::unique_ptr<AcceptQueue>& queuePtr = acceptQueues[servSock.getFd()];
+        if(!queuePtr){
+            queuePtr = std::make_unique<AcceptQueue>();
+            queuePtr->server = &servSock;
+            queuePtr->fd = servSock.getFd();
+        }
+
+        AcceptQueue& queue = *queuePtr;
+        queue.cancelled = false;
+        queue.waiting.push_back(std::move(callback));
+        matchAccepts(queue);
+        if(!queue.waiting.empty()){
+            armAccept(queue);
+        }
+    }
+
+    void UringBackend::submit(const StrSoConnect&, const SocketAddress& address, SocketCallback callback){
+        if(!supportsOp(IORING_OP_CONNECT)){
+            stats.fallbackOps++;
+            deferred.push_back([address, callback = std::move(callback)](){
+                StreamSocket strSock;
+                try{
+                    strSock.connect(address);
+                }catch(SnlException& e){
+                    callback(StreamSocket(), e.getErrorCode());
+                    return;
+                }
+                callback(std::move(strSock), std::error_code());
+            });
+            return;
+        }
+
+        auto operation = std::make_unique<Operation>(Operation::Kind::CONNECT);
+        operation->socketCallback = std::move(callback);
+        operation->connectFd = makeFdGuard(::socket, address.getAddressFamily(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        operation->storage = address.getSockaddrStorage();
+
+        Fd fd = operation->connectFd.get();
+        const sockaddr_storage* storage = &operation->storage;
+        io_uring_sqe* sqe = prepare(IORING_OP_CONNECT, fd, std::move(operation));
+        sqe->addr = reinterpret_cast<std::uint64_t>(storage);
+        sqe->off = address.getAddrlen(); //the connect opcode takes the address length in the offset
+    }
+
+    bool UringBackend::registerBuffers(std::vector<iovec> buffers){
+        registeredBuffers = std::move(buffers);
+        if(!ring){
+            return false;
+        }
+
+        if(fixedBuffers){
+            ioUringRegister(ring->ringFd.get(), IORING_UNREGISTER_BUFFERS, nullptr, 0);
+            fixedBuffers = false;
+        }
+
+        //fails if the buffers exceed the locked memory limit or the kernel lacks support
+        int status = ioUringRegister(ring->ringFd.get(), IORING_REGISTER_BUFFERS, registeredBuffers.data(), static_cast<unsigned>(registeredBuffers.size()));
+        fixedBuffers = status != -1;
+        return fixedBuffers;
+    }
+
+    void UringBackend::submitFixed(const StrSoSend&, StreamSocket& strSock, std::size_t bufferIndex, std::size_t offset, std::size_t size, IoCallback callback){
+        if(bufferIndex >= registeredBuffers.size() || offset + size > registeredBuffers[bufferIndex].iov_len){
+            throw SnlException("UringBackend error: send outside of the registered buffer");
+        }
+        char* buffer = static_cast<char*>(registeredBuffers[bufferIndex].iov_base) + offset;
+
+        if(!fixedBuffers || !supportsOp(IORING_OP_WRITE_FIXED)){
+            submit(sendAct, strSock, buffer, size, 0, std::move(callback));
+            return;
+        }
+
+        if(!strSock.isConnected() || strSock.upstreamClosed()){
+            throw SnlException("UringBackend error: trying to send with a socket that is not connected");
+        }
+
+        auto operation = std::make_unique<Operation>(Operation::Kind::SEND);
+        operation->ioCallback = std::move(callback);
+        io_uring_sqe* sqe = prepare(IORING_OP_WRITE_FIXED, strSock.getFd(), std::move(operation));
+        sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe->len = static_cast<std::uint32_t>(size);
+        sqe->buf_index = static_cast<std::uint16_t>(bufferIndex);
+        sqe->off = static_cast<std::uint64_t>(-1); //sockets have no file position
+    }
+
+    void UringBackend::submitFixed(const StrSoReceive&, StreamSocket& strSock, std::size_t bufferIndex, std::size_t offset, std::size_t size, IoCallback callback){
+        if(bufferIndex >= registeredBuffers.size() || offset + size > registeredBuffers[bufferIndex].iov_len){
+            throw SnlException("UringBackend error: receive outside of the registered buffer");
+        }
+        char* buffer = static_cast<char*>(registeredBuffers[bufferIndex].iov_base) + offset;
+
+        if(!fixedBuffers || !supportsOp(IORING_OP_READ_FIXED)){
+            submit(receiveAct, strSock, buffer, size, 0, std::move(callback));
+            return;
+        }
+
+        if(!strSock.isConnected() || strSock.downStreamClosed()){
+            throw SnlException("UringBackend error: trying to receive with a socket that is not connected");
+        }
+
+        auto operation = std::make_unique<Operation>(Operation::Kind::RECEIVE);
+        operation->ioCallback = std::move(callback);
+        io_uring_sqe* sqe = prepare(IORING_OP_READ_FIXED, strSock.getFd(), std::move(operation));
+        sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe->len = static_cast<std::uint32_t>(size);
+        sqe->buf_index = static_cast<std::uint16_t>(bufferIndex);
+        sqe->off = static_cast<std::uint64_t>(-1);
+    }
+
+    void UringBackend::cancelAccept(ServerSocket& servSock){
+        auto queueIt = acceptQueues.find(servSock.getFd());
+        if(queueIt == acceptQueues.end()){
+            return;
+        }
+
+        AcceptQueue& queue = *queueIt->second;
+        queue.cancelled = true;
+        if(queue.armed){
+            std::uint64_t target = queue.userData;
+            io_uring_sqe* sqe = prepare(IORING_OP_ASYNC_CANCEL, -1, std::make_unique<Operation>(Operation::Kind::CANCEL));
+            sqe->addr = target;
+        }
+    }
+
+    /*
+     * accept handling
+     */
+
+    void UringBackend::armAccept(AcceptQueue& queue){
+        if(queue.armed || queue.cancelled){
+            return;
+        }
+
+        auto operation = std::make_unique<Operation>(Operation::Kind::ACCEPT);
+        operation->acceptQueue = &queue;
+        operation->multishot = multishotAccept;
+        sockaddr_storage* storage = &operation->storage;
+        socklen_t* addrlen = &operation->addrlen;
+        //armed before preparing, a full submission queue must not lead to a second accept for the queue
+        queue.armed = true;
+        io_uring_sqe* sqe;
+        try{
+            sqe = prepare(IORING_OP_ACCEPT, queue.fd, std::move(operation));
+        }catch(SnlException&){
+            queue.armed = false;
+            throw;
+        }
+        sqe->accept_flags = SOCK_CLOEXEC;
+        if(multishotAccept){
+            //every completion would overwrite the one address buffer, the socket fetches its peer address when asked
+            sqe->addr = 0;
+            sqe->addr2 = 0;
+            sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+        }else{
+            sqe->addr = reinterpret_cast<std::uint64_t>(storage);
+            sqe->addr2 = reinterpret_cast<std::uint64_t>(addrlen);
+        }
+
+        queue.userData = sqe->user_data;
+    }
+
+    void UringBackend::handleAccept(AcceptQueue& queue, int result, std::uint32_t flags, bool multishot, const sockaddr_storage* peer){
+        bool more = flags & IORING_CQE_F_MORE;
+        if(!more){
+            queue.armed = false;
+        }
+
+        if(result >= 0){
+            AcceptQueue::Accepted& accepted = queue.ready.emplace_back(FdGuard(result), sockaddr_storage{}, peer != nullptr);
+            if(peer){
+                accepted.storage = *peer;
+            }
+        }else if(multishot && result == -EINVAL && !more){
+            //the kernel does not know multishot accepts, retry with single shot accepts
+            multishotAccept = false;
+        }else if(result == -ECANCELED){
+            //cancelAccept was called, none of the waiting callbacks will get a connection
+            std::deque<SocketCallback> cancelled;
+            cancelled.swap(queue.waiting);
+            for(auto& callback : cancelled){
+                callback(StreamSocket(), makeErrorCode(ECANCELED));
+            }
+        }else if(!queue.waiting.empty()){
+            SocketCallback callback = std::move(queue.waiting.front());
+            queue.waiting.pop_front();
+            callback(StreamSocket(), makeErrorCode(-result));
+        }
+
+        matchAccepts(queue);
+        if(!queue.waiting.empty()){
+            armAccept(queue);
+        }
+    }
+
+    void UringBackend::matchAccepts(AcceptQueue& queue){
+        while(!queue.ready.empty() && !queue.waiting.empty()){
+            AcceptQueue::Accepted accepted = std::move(queue.ready.front());
+            queue.ready.pop_front();
+            SocketCallback callback = std::move(queue.waiting.front());
+            queue.waiting.pop_front();
+
+            if(accepted.hasAddress){
+                callback(StreamSocket(std::move(accepted.guard), makeSockAddr(accepted.storage)), std::error_code());
+            }else{
+                callback(StreamSocket(std::move(accepted.guard), false), std::error_code());
+            }
+        }
+    }
+
+    /*
+     * completion handling
+     */
+
+    std::size_t UringBackend::flush(){
+        if(!ring || ring->toSubmit == 0){
+            return 0;
+        }
+
+        int submitted = ioUringEnter(ring->ringFd.get(), ring->toSubmit, 0, 0);
+        stats.enterCalls++;
+        if(submitted == -1){
+            if(errno == EINTR || errno == EAGAIN || errno == EBUSY){
+                return 0; //try again on the next flush
+            }
+            throw SnlException("UringBackend error: ", errno);
+        }
+
+        ring->toSubmit -= static_cast<unsigned>(submitted);
+        stats.submittedOps += static_cast<std::size_t>(submitted);
+        return static_cast<std::size_t>(submitted);
+    }
+
+    std::size_t UringBackend::complete(unsigned minCompletions){
+        std::size_t delivered = 0;
+
+        //first the operations that did not go through the ring
+        std::deque<std::function<void()>> fallbacks;
+        fallbacks.swap(deferred);
+        for(auto& fallback : fallbacks){
+            fallback();
+            delivered++;
+        }
+        stats.completedOps += delivered;
+
+        if(!ring){
+            return delivered;
+        }
+
+        //then the completions reaped while preparing entries
+        delivered += deliverReaped();
+
+        unsigned waitFor = delivered >= minCompletions ? 0 : minCompletions - static_cast<unsigned>(delivered);
+        unsigned ready = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE) - *ring->cqHead;
+
+        //only enter the kernel if there is something to submit or not enough completions are ready
+        if(ring->toSubmit != 0 || ready < waitFor){
+            unsigned flags = waitFor > ready ? IORING_ENTER_GETEVENTS : 0;
+            int submitted = ioUringEnter(ring->ringFd.get(), ring->toSubmit, waitFor > ready ? waitFor : 0, flags);
+            stats.enterCalls++;
+            if(submitted == -1){
+                if(errno != EINTR && errno != EAGAIN && errno != EBUSY){
+                    throw SnlException("UringBackend error: ", errno);
+                }
+            }else{
+                ring->toSubmit -= static_cast<unsigned>(submitted);
+                stats.submittedOps += static_cast<std::size_t>(submitted);
+            }
+        }
+
+        reap();
+        delivered += deliverReaped();
+        return delivered;
+    }
+
+    std::size_t UringBackend::reap(){
+        std::size_t count = 0;
+        unsigned head = *ring->cqHead;
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        while(head != tail){
+            const io_uring_cqe& cqe = ring->cqes[head & *ring->cqMask];
+            reaped.push_back(Reaped{cqe.user_data, cqe.res, cqe.flags});
+            head++;
+            count++;
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    std::size_t UringBackend::deliverReaped(){
+        std::size_t count = 0;
+        //the callbacks may prepare new entries and so reap more completions, those are delivered by this loop too
+        while(!reaped.empty()){
+            Reaped completion = reaped.front();
+            reaped.pop_front();
+            handleCompletion(completion.userData, completion.result, completion.flags);
+            count++;
+            stats.completedOps++;
+        }
+        return count;
+    }
+
+    void UringBackend::handleCompletion(std::uint64_t userData, int result, std::uint32_t flags){
+        auto opIt = inFlight.find(userData);
+        if(opIt == inFlight.end()){
+            return;
+        }
+
+        Operation& operation = *opIt->second;
+        switch(operation.kind){
+            case Operation::Kind::SEND:
+            case Operation::Kind::RECEIVE:{
+                IoCallback callback = std::move(operation.ioCallback);
+                inFlight.erase(opIt);
+                if(result < 0){
+                    callback(0, makeErrorCode(-result));
+                }else{
+                    callback(static_cast<std::size_t>(result), std::error_code());
+                }
+                break;
+            }
+            case Operation::Kind::CONNECT:{
+                std::unique_ptr<Operation> connectOp = std::move(opIt->second);
+                inFlight.erase(opIt);
+                if(result < 0){
+                    connectOp->socketCallback(StreamSocket(), makeErrorCode(-result));
+                }else{
+                    connectOp->socketCallback(StreamSocket(std::move(connectOp->connectFd), makeSockAddr(connectOp->storage)), std::error_code());
+                }
+                break;
+            }
+            case Operation::Kind::ACCEPT:{
+                AcceptQueue& queue = *operation.acceptQueue;
+                bool multishot = operation.multishot;
+                if(flags & IORING_CQE_F_MORE){
+                    handleAccept(queue, result, flags, multishot, nullptr);
+                    break;
+                }
+                //the accept is no longer armed, the operation (and its address) is released after the handling
+                std::unique_ptr<Operation> acceptOp = std::move(opIt->second);
+                inFlight.erase(opIt);
+                handleAccept(queue, result, flags, multishot, multishot ? nullptr : &acceptOp->storage);
+                break;
+            }
+            case Operation::Kind::CANCEL:
+                inFlight.erase(opIt);
+                break;
+        }
+    }
+}
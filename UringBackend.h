@@ -0,0 +1,180 @@
+#ifndef URINGBACKEND_H
+#define URINGBACKEND_H
+//c headers
+#include <sys/uio.h>
+//cpp headers
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+//own headers
+#include "FdGuard.h"
+#include "StreamSocketFsm.h"
+#include "ServerSocketFsm.h"
+
+//forward declarations
+struct io_uring_sqe;
+
+namespace snl{
+
+    //forward declarations
+    class ServerSocket;
+    class StreamSocket;
+
+    /**
+     * Completion based io backend built on io_uring
+     * operations are queued with submit (using the same action tags as the socket fsms) and are handed
+     * to the kernel in batches: one io_uring_enter covers every operation queued since the last one.
+     * If io_uring is not available (old kernel, disabled by sysctl, ...) every operation falls back to
+     * the regular syscall path and its completion is delivered by the next call to complete().
+     */
+    class UringBackend
+    {
+    public:
+
+        //completion of a send/receive: the number of bytes transferred or the error that occurred
+        //note: a receive that completes with 0 bytes for a non empty buffer indicates the end of the stream
+        using IoCallback = std::function<void(std::size_t bytes, std::error_code error)>;
+        //completion of an accept/connect: the connected socket, only valid if there is no error
+        using SocketCallback = std::function<void(StreamSocket&& strSock, std::error_code error)>;
+
+        struct Stats{
+            std::size_t enterCalls = 0; //number of io_uring_enter syscalls
+            std::size_t submittedOps = 0; //operations handed to the kernel
+            std::size_t completedOps = 0; //completions delivered to the callbacks
+            std::size_t fallbackOps = 0; //operations executed with the regular syscalls
+        };
+
+        explicit UringBackend(unsigned entries = defaultEntries);
+        ~UringBackend();
+
+        UringBackend(const UringBackend& rhs) = delete;
+        UringBackend& operator=(const UringBackend& rhs) = delete;
+
+        /**
+         * @brief queues a send on the connected socket
+         * note: the buffer and the socket must stay alive until the completion is delivered
+         */
+        void submit(const StrSoSend&, StreamSocket& strSock, const void* buffer, std::size_t bufferSize, int flags, IoCallback callback);
+
+        /**
+         * @brief queues a receive on the connected socket
+         * note: the buffer and the socket must stay alive until the completion is delivered
+         */
+        void submit(const StrSoReceive&, StreamSocket& strSock, void* buffer, std::size_t bufferSize, int flags, IoCallback callback);
+
+        /**
+         * @brief queues the acceptance of the next connection on the listening socket
+         * note: where supported a single multishot accept stays armed for the server socket, connections
+         *       accepted while no accept is queued are kept until the next submit
+         */
+        void submit(const ServerAccept&, ServerSocket& servSock, SocketCallback callback);
+
+        /**
+         * @brief queues a connect to the provided address, the callback receives the connected socket
+         */
+        void submit(const StrSoConnect&, const SocketAddress& address, SocketCallback callback);
+
+        /**
+         * @brief registers buffers with the kernel so sends and receives on them skip the page mapping
+         * @param buffers the buffers to register, replaces the previously registered set
+         * @return true if the buffers are registered, false if the kernel does not support it
+         *         (the fixed submits will then use the regular path)
+         */
+        bool registerBuffers(std::vector<iovec> buffers);
+
+        /**
+         * @brief queues a send from a registered buffer
+         * @param bufferIndex the index of the buffer in the registered set
+         * @param offset the offset in the registered buffer to start sending from
+         */
+        void submitFixed(const StrSoSend&, StreamSocket& strSock, std::size_t bufferIndex, std::size_t offset, std::size_t size, IoCallback callback);
+
+        /**
+         * @brief queues a receive into a registered buffer
+         * @param bufferIndex the index of the buffer in the registered set
+         * @param offset the offset in the registered buffer to start writing to
+         */
+        void submitFixed(const StrSoReceive&, StreamSocket& strSock, std::size_t bufferIndex, std::size_t offset, std::size_t size, IoCallback callback);
+
+        /**
+         * @brief stops accepting connections on the server socket, pending accept callbacks
+         *        receive ECANCELED once the cancellation completes
+         */
+        void cancelAccept(ServerSocket& servSock);
+
+        /**
+         * @brief hands all the queued operations to the kernel with a single syscall
+         * @return the number of operations submitted
+         */
+        std::size_t flush();
+
+        /**
+         * @brief submits the queued operations, waits for completions and delivers them
+         * @param minCompletions the number of completions to wait for (0 to only reap what is ready)
+         * @return the number of completions delivered
+         */
+        std::size_t complete(unsigned minCompletions = 1);
+
+        /**
+         * @brief checks if the kernel io_uring path is used (false if everything falls back to syscalls)
+         */
+        bool isUringEnabled() const noexcept;
+
+        Stats getStats() const noexcept;
+
+        static constexpr unsigned defaultEntries = 256;
+
+    private:
+
+        struct Ring; //the mapped submission and completion queues
+        struct Operation; //the state of an operation in flight
+        struct AcceptQueue; //the accept state kept per server socket
+
+        //a completion copied out of the completion queue, not yet delivered
+        struct Reaped{
+            std::uint64_t userData;
+            int result;
+            std::uint32_t flags;
+        };
+
+        //returns a free submission entry for the operation, flushes (and reaps completions) if the queue is full
+        io_uring_sqe* prepare(std::uint8_t opcode, Fd fd, std::unique_ptr<Operation> operation);
+        //moves the ready completion queue entries to reaped without running any callback, returns their number
+        std::size_t reap();
+        //delivers the reaped completions, returns their number
+        std::size_t deliverReaped();
+        //delivers a completion queue entry to its operation
+        void handleCompletion(std::uint64_t userData, int result, std::uint32_t flags);
+        //peer: the address the kernel filled in for a single shot accept, nullptr for a multishot accept
+        void handleAccept(AcceptQueue& queue, int result, std::uint32_t flags, bool multishot, const sockaddr_storage* peer);
+        //makes sure an accept is in flight for the queue
+        void armAccept(AcceptQueue& queue);
+        //delivers the ready connections to the waiting callbacks
+        void matchAccepts(AcceptQueue& queue);
+
+        bool supportsOp(std::uint8_t opcode) const noexcept;
+        void probeOps();
+
+        std::unique_ptr<Ring> ring;
+        std::vector<bool> supportedOps; //per opcode, filled by probing the kernel
+        bool multishotAccept = true; //cleared when the kernel rejects a multishot accept
+        bool fixedBuffers = false; //true if buffers are registered
+        std::vector<iovec> registeredBuffers;
+
+        std::uint64_t nextUserData = 1;
+        std::unordered_map<std::uint64_t, std::unique_ptr<Operation>> inFlight;
+        std::unordered_map<Fd, std::unique_ptr<AcceptQueue>> acceptQueues;
+        //completions of operations that did not go through the ring, delivered on complete()
+        std::deque<std::function<void()>> deferred;
+        //completions reaped while preparing an entry, delivered by complete() only (prepare runs inside the callbacks)
+        std::deque<Reaped> reaped;
+
+        Stats stats;
+    };
+}
+
+#endif // URINGBACKEND_H
@@ -0,0 +1,104 @@
+#include "WriteBatch.h"
+//c headers
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+//cpp headers
+#include <algorithm>
+#include <cstring>
+//own headers
+#include "FdGuard.h"
+#include "SnlException.h"
+#include "StreamSocket.h"
+
+namespace snl{
+
+    WriteBatch::WriteBatch(StreamSocket& strSock_, std::size_t bufferSize) :
+        strSock(strSock_), copyBuffer(BufferPool::getDefault().acquire(bufferSize)) { }
+
+    WriteBatch::~WriteBatch(){
+        try{
+            flush();
+        }catch(SnlException&){
+            //the connection broke, the owner of the socket finds out on its next call
+        }
+    }
+
+    void WriteBatch::append(const void* buffer, std::size_t bufferSize){
+        //always copied, the caller may reuse or free the buffer right after the call
+        //(only appendRef keeps a reference), a large buffer is copied in pieces of the copy buffer
+        const char* data = static_cast<const char*>(buffer);
+        while(bufferSize != 0){
+            if(copied == copyBuffer.capacity()){
+                flush();
+            }
+            std::size_t pieceSize = std::min(bufferSize, copyBuffer.capacity() - copied);
+            char* copy = copyBuffer.data() + copied;
+            std::memcpy(copy, data, pieceSize);
+            copied += pieceSize;
+            addSegment(copy, pieceSize);
+            data += pieceSize;
+            bufferSize -= pieceSize;
+        }
+    }
+
+    void WriteBatch::appendRef(const void* buffer, std::size_t bufferSize){
+        addSegment(static_cast<const char*>(buffer), bufferSize);
+    }
+
+    void WriteBatch::flush(){
+        if(segments.empty()){
+            return;
+        }
+        //the batch is empty again even if the send fails, the socket is broken in that case anyway
+        std::vector<iovec> flushing;
+        flushing.swap(segments);
+        copied = 0;
+        pendingBytes = 0;
+        sendAllv(strSock, flushing);
+        flushing.clear();
+        segments.swap(flushing); //keep the capacity of the list
+    }
+
+    std::size_t WriteBatch::getPendingBytes() const noexcept{
+        return pendingBytes;
+    }
+
+    void WriteBatch::addSegment(const char* buffer, std::size_t bufferSize){
+        if(bufferSize == 0){
+            return;
+        }
+        pendingBytes += bufferSize;
+        if(!segments.empty()){
+            iovec& last = segments.back();
+            if(static_cast<char*>(last.iov_base) + last.iov_len == buffer){
+                last.iov_len += bufferSize;
+                return;
+            }
+        }
+        segments.push_back(iovec{const_cast<char*>(buffer), bufferSize});
+    }
+
+    void sendline(WriteBatch& batch, std::string_view line, std::string_view eol){
+        batch.append(line.data(), line.size());
+        batch.append(eol.data(), eol.size());
+    }
+
+    Cork::Cork(StreamSocket& strSock) : fd(strSock.getFd()){
+        setCork(fd, true);
+    }
+
+    Cork::~Cork(){
+        try{
+            setCork(fd, false);
+        }catch(SnlException&){
+            //the socket was closed while corked, nothing is left to send
+        }
+    }
+
+    void Cork::setCork(int fd, bool corked){
+        int failure = -1;
+        int value = corked ? 1 : 0;
+        executeSyscall(::setsockopt, failure, fd, IPPROTO_TCP, TCP_CORK, &value, static_cast<socklen_t>(sizeof(value)));
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef WRITEBATCH_H
+#define WRITEBATCH_H
+//c headers
+#include <sys/uio.h>
+//cpp headers
+#include <string_view>
+#include <vector>
+//own headers
+#include "BufferPool.h"
+
+namespace snl{
+
+    //forward declarations
+    class StreamSocket;
+
+    /**
+     * Gathers the writes of a response in user space and sends them with a single gather send
+     * the append writes are copied into a pooled buffer, consecutive copies become one segment. The appendRef
+     * writes are referenced instead of copied.
+     * The batch is flushed on flush(), when the buffer is full and on destruction.
+     * usage:
+     *     {
+     *         WriteBatch batch(strSock);
+     *         sendline(batch, "HTTP/1.1 200 OK");
+     *         sendline(batch, "Content-Length: 5");
+     *         sendline(batch, "");
+     *         batch.append("hello", 5);
+     *     } //one sendmsg for the whole response
+     * note: like sendBuff, the flush blocks until everything is sent
+     */
+    class WriteBatch
+    {
+    public:
+
+        static constexpr std::size_t defaultBufferSize = 16 * 1024;
+
+        /**
+         * @param strSock the socket to send on, must outlive the batch
+         * @param bufferSize the size of the copy buffer, the batch is flushed each time it fills up
+         */
+        explicit WriteBatch(StreamSocket& strSock, std::size_t bufferSize = defaultBufferSize);
+
+        /**
+         * @brief flushes the remaining writes
+         * note: a failing send is not reported here (the socket reports it on its next use), call flush
+         *       explicitly to see the error
+         */
+        ~WriteBatch();
+
+        WriteBatch(const WriteBatch& rhs) = delete;
+        WriteBatch& operator=(const WriteBatch& rhs) = delete;
+
+        /**
+         * @brief adds a copy of the buffer to the batch
+         * note: a buffer larger than the copy buffer is copied in pieces, flushing in between
+         */
+        void append(const void* buffer, std::size_t bufferSize);
+
+        /**
+         * @brief adds the buffer to the batch without copying it
+         * note: the buffer must stay alive and unchanged until the next flush
+         */
+        void appendRef(const void* buffer, std::size_t bufferSize);
+
+        /**
+         * @brief sends all the gathered writes
+         */
+        void flush();
+
+        std::size_t getPendingBytes() const noexcept;
+
+    private:
+
+        //adds the segment, merging it with the previous one if they are contiguous
+        void addSegment(const char* buffer, std::size_t bufferSize);
+
+        StreamSocket& strSock;
+        PooledBuffer copyBuffer;
+        std::size_t copied = 0; //bytes used in the copy buffer
+        std::size_t pendingBytes = 0;
+        std::vector<iovec> segments;
+    };
+
+    /**
+     * @brief adds a line followed by the end of line delimiter to the batch (the batched variant of sendline)
+     */
+    void sendline(WriteBatch& batch, std::string_view line, std::string_view eol = "\r\n");
+
+    /**
+     * Corks the socket (TCP_CORK) for its lifetime: the kernel only sends full segments while corked and
+     * sends the rest when the cork is removed. The alternative to a WriteBatch when the writes can not be
+     * gathered in user space (e.g. a sendFile between the headers and the trailer).
+     */
+    class Cork
+    {
+    public:
+
+        explicit Cork(StreamSocket& strSock);
+        ~Cork(); //uncorks, which sends the partial segment
+
+        Cork(const Cork& rhs) = delete;
+        Cork& operator=(const Cork& rhs) = delete;
+
+    private:
+
+        static void setCork(int fd, bool corked);
+
+        int fd;
+    };
+}
+
+#endif // WRITEBATCH_H
@@ -0,0 +1,152 @@
+#include "WriteQueue.h"
+//c headers
+#include <sys/uio.h>
+//cpp headers
+#include <algorithm>
+#include <cstring>
+//own headers
+#include "EventLoop.h"
+#include "SnlException.h"
+#include "StreamSocket.h"
+
+namespace snl{
+
+    constexpr std::size_t maxFlushSegments = 16; //chunks gathered in a single send
+
+    WriteQueue::WriteQueue(EventLoop& loop_, StreamSocket& strSock_, Limits limits_) : loop(loop_), strSock(strSock_), limits(limits_){
+        if(limits.lowWatermark >= limits.highWatermark || limits.highWatermark > limits.maxBytes){
+            throw SnlException("WriteQueue error: the watermarks must satisfy low < high <= maxBytes");
+        }
+    }
+
+    WriteQueue::WriteQueue(EventLoop& loop_, StreamSocket& strSock_) : WriteQueue(loop_, strSock_, Limits{}) { }
+
+    bool WriteQueue::write(const void* buffer, std::size_t bufferSize){
+        if(queuedBytes + bufferSize > limits.maxBytes){
+            return false;
+        }
+
+        const char* data = static_cast<const char*>(buffer);
+        //only an empty queue may send directly, otherwise the data would overtake the queued bytes
+        if(queuedBytes == 0){
+            std::size_t bytesSent = 0;
+            if(strSock.trySend(data, bufferSize, bytesSent)){
+                data += bytesSent;
+                bufferSize -= bytesSent;
+            }
+        }
+        enqueue(data, bufferSize);
+        update();
+        return true;
+    }
+
+    bool WriteQueue::write(std::string_view buffer){ return write(buffer.data(), buffer.size()); }
+
+    bool WriteQueue::flush(){
+        while(queuedBytes != 0){
+            iovec segments[maxFlushSegments];
+            std::size_t segmentCount = 0;
+            for(std::size_t index = 0; index != chunks.size() && segmentCount != maxFlushSegments; ++index){
+                std::size_t begin = index == 0 ? head : 0;
+                std::size_t end = index + 1 == chunks.size() ? tail : chunks[index].capacity();
+                segments[segmentCount++] = iovec{chunks[index].data() + begin, end - begin};
+            }
+
+            std::size_t bytesSent = 0;
+            if(!strSock.trySendv(std::span<const iovec>(segments, segmentCount), bytesSent)){
+                break; //the socket is full, the write interest brings us back
+            }
+            consume(bytesSent);
+        }
+        update();
+        return queuedBytes == 0;
+    }
+
+    void WriteQueue::clear() noexcept{
+        chunks.clear();
+        head = tail = queuedBytes = 0;
+        aboveHigh = false;
+        if(writeInterest){
+            try{
+                loop.watchWritable(strSock, false);
+            }catch(SnlException&){
+                //the stream already left the loop
+            }
+            writeInterest = false;
+        }
+    }
+
+    void WriteQueue::setHighWatermarkCallback(WatermarkCallback onHigh_){ onHigh = std::move(onHigh_); }
+
+    void WriteQueue::setLowWatermarkCallback(WatermarkCallback onLow_){ onLow = std::move(onLow_); }
+
+    std::size_t WriteQueue::getQueuedBytes() const noexcept{
+        return queuedBytes;
+    }
+
+    bool WriteQueue::isEmpty() const noexcept{
+        return queuedBytes == 0;
+    }
+
+    bool WriteQueue::isAboveHighWatermark() const noexcept{
+        return aboveHigh;
+    }
+
+    StreamSocket& WriteQueue::getSocket() noexcept{
+        return strSock;
+    }
+
+    void WriteQueue::enqueue(const char* buffer, std::size_t bufferSize){
+        while(bufferSize != 0){
+            if(chunks.empty() || tail == chunks.back().capacity()){
+                chunks.push_back(BufferPool::getDefault().acquire(limits.chunkSize));
+                tail = 0;
+            }
+            std::size_t copied = std::min(bufferSize, chunks.back().capacity() - tail);
+            std::memcpy(chunks.back().data() + tail, buffer, copied);
+            tail += copied;
+            buffer += copied;
+            bufferSize -= copied;
+            queuedBytes += copied;
+        }
+    }
+
+    void WriteQueue::consume(std::size_t byteCount) noexcept{
+        queuedBytes -= byteCount;
+        while(byteCount != 0){
+            std::size_t end = chunks.size() == 1 ? tail : chunks.front().capacity();
+            std::size_t dropped = std::min(byteCount, end - head);
+            head += dropped;
+            byteCount -= dropped;
+            if(head == end){
+                //the chunk goes back to the pool, a fully drained queue keeps no memory
+                chunks.pop_front();
+                head = 0;
+                if(chunks.empty()){
+                    tail = 0;
+                }
+            }
+        }
+    }
+
+    void WriteQueue::update(){
+        bool wantWritable = queuedBytes != 0;
+        if(wantWritable != writeInterest){
+            loop.watchWritable(strSock, wantWritable);
+            writeInterest = wantWritable;
+        }
+
+        //the state changes before the callback, a callback that writes or clears sees the new state
+        if(!aboveHigh && queuedBytes >= limits.highWatermark){
+            aboveHigh = true;
+            if(onHigh){
+                onHigh(*this);
+            }
+        }else if(aboveHigh && queuedBytes <= limits.lowWatermark){
+            aboveHigh = false;
+            if(onLow){
+                onLow(*this);
+            }
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef WRITEQUEUE_H
+#define WRITEQUEUE_H
+//c headers
+//cpp headers
+#include <deque>
+#include <functional>
+#include <string_view>
+//own headers
+#include "BufferPool.h"
+
+namespace snl{
+
+    //forward declarations
+    class EventLoop;
+    class StreamSocket;
+
+    /**
+     * Bounded queue of outgoing data for a non blocking stream owned by an event loop
+     * a write is sent right away as far as the socket takes it, the rest is copied into pooled chunks and sent
+     * when the socket becomes writable again. The queue holds at most maxBytes: producers are told to pause
+     * when the queued bytes reach the high watermark and to resume once they drained to the low watermark,
+     * so a slow reader neither blocks the loop nor grows the memory without bound.
+     * usage:
+     *     handlers.onWritable = [&queue](EventLoop&, StreamSocket&){ queue.flush(); };
+     * note: the queue sets and clears the write interest of the stream itself, the onWritable handler of the
+     *       stream must call flush
+     * note: the stream must outlive the queue (remove the queue before removing the stream from the loop)
+     */
+    class WriteQueue
+    {
+    public:
+
+        //called when the queued bytes cross a watermark
+        using WatermarkCallback = std::function<void(WriteQueue&)>;
+
+        struct Limits{
+            std::size_t lowWatermark = 64 * 1024; //resume the producers at or below this
+            std::size_t highWatermark = 256 * 1024; //pause the producers at or above this
+            std::size_t maxBytes = 1024 * 1024; //the byte budget, writes that do not fit are refused
+            std::size_t chunkSize = 16 * 1024; //the size of the pooled chunks the data is queued in
+        };
+
+        /**
+         * @param loop the loop that owns the stream
+         * @param strSock the stream (as returned by EventLoop::addStream)
+         * @param limits the watermarks and the budget, the low watermark must be below the high watermark
+         */
+        WriteQueue(EventLoop& loop, StreamSocket& strSock, Limits limits);
+        WriteQueue(EventLoop& loop, StreamSocket& strSock);
+
+        WriteQueue(const WriteQueue& rhs) = delete;
+        WriteQueue& operator=(const WriteQueue& rhs) = delete;
+
+        /**
+         * @brief sends or queues the buffer
+         * @return false if the buffer does not fit in the byte budget (nothing is sent or queued)
+         * @throws SnlException if the send fails
+         */
+        bool write(const void* buffer, std::size_t bufferSize);
+        bool write(std::string_view buffer);
+
+        /**
+         * @brief sends as much of the queued data as the socket takes without blocking
+         * @return true if the queue is empty afterwards
+         * @throws SnlException if the send fails
+         */
+        bool flush();
+
+        /**
+         * @brief drops the queued data (e.g. when the connection is reset)
+         */
+        void clear() noexcept;
+
+        void setHighWatermarkCallback(WatermarkCallback onHigh);
+        void setLowWatermarkCallback(WatermarkCallback onLow);
+
+        std::size_t getQueuedBytes() const noexcept;
+        bool isEmpty() const noexcept;
+        //true between the high watermark callback and the low watermark callback
+        bool isAboveHighWatermark() const noexcept;
+        StreamSocket& getSocket() noexcept;
+
+    private:
+
+        //copies the buffer behind the queued data
+        void enqueue(const char* buffer, std::size_t bufferSize);
+        //drops byteCount sent bytes from the front of the queue
+        void consume(std::size_t byteCount) noexcept;
+        //fires the watermark callbacks and keeps the write interest in line with the queue
+        void update();
+
+        EventLoop& loop;
+        StreamSocket& strSock;
+        Limits limits;
+        std::deque<PooledBuffer> chunks;
+        std::size_t head = 0; //offset of the first unsent byte in the front chunk
+        std::size_t tail = 0; //bytes used in the back chunk
+        std::size_t queuedBytes = 0;
+        bool aboveHigh = false;
+        bool writeInterest = false;
+        WatermarkCallback onHigh;
+        WatermarkCallback onLow;
+    };
+}
+
+#endif // WRITEQUEUE_H
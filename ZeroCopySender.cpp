@@ -0,0 +1,172 @@
+#include "ZeroCopySender.h"
+//c headers
+#include <cerrno>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+//cpp headers
+#include <algorithm>
+#include <utility>
+#include <vector>
+//own headers
+#include "SnlException.h"
+#include "StreamSocket.h"
+
+namespace snl{
+
+    ZeroCopySender::ZeroCopySender(StreamSocket& strSock_, std::size_t threshold_) : strSock(strSock_), threshold(threshold_){
+        int enable = 1;
+        //older kernels and some socket types refuse the option, everything is then copied
+        zeroCopy = ::setsockopt(strSock.getFd(), SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == 0;
+    }
+
+    ZeroCopySender::~ZeroCopySender() = default;
+
+    void ZeroCopySender::send(const void* buffer, std::size_t bufferSize, ReleaseCallback onRelease){
+        if(!zeroCopy || bufferSize < threshold){
+            sendBuff(strSock, buffer, bufferSize);
+            if(onRelease){
+                onRelease();
+            }
+            return;
+        }
+
+        //the buffer stays the last entry while it is being sent, release only removes queued entries
+        PendingBuffer entry;
+        entry.first = nextSequence;
+        entry.onRelease = std::move(onRelease);
+        pending.push_back(std::move(entry));
+
+        const char* bufferHead = static_cast<const char*>(buffer);
+        std::size_t bytesSent = 0;
+        try{
+            while(bytesSent != bufferSize){
+                try{
+                    bytesSent += strSock.send(bufferHead + bytesSent, bufferSize - bytesSent, MSG_ZEROCOPY);
+                    pending.back().sends++;
+                    pending.back().remaining++;
+                    nextSequence++;
+                }catch(SnlException& e){
+                    //the kernel could not pin more pages, wait for earlier sends to complete or copy the rest
+                    if(e.getErrorNo() != ENOBUFS){
+                        throw;
+                    }
+                    bool inFlight = std::any_of(pending.begin(), pending.end(), [](const PendingBuffer& buffer){ return buffer.remaining != 0; });
+                    if(inFlight){
+                        waitCompletions();
+                        pollCompletions();
+                    }else{
+                        bytesSent += strSock.send(bufferHead + bytesSent, bufferSize - bytesSent);
+                    }
+                }
+            }
+        }catch(...){
+            //the sends already made still complete, the buffer is released once they did
+            pending.back().queued = true;
+            throw;
+        }
+        pending.back().queued = true;
+        release();
+    }
+
+    std::size_t ZeroCopySender::pollCompletions(){
+        while(true){
+            char control[128];
+            msghdr message{};
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            if(::recvmsg(strSock.getFd(), &message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1){
+                if(errno == EAGAIN || errno == EWOULDBLOCK){
+                    break;
+                }
+                if(errno == EINTR){
+                    continue;
+                }
+                throw SnlException("ZeroCopySender error: ", errno);
+            }
+
+            for(cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)){
+                bool recvErr = (header->cmsg_level == SOL_IP && header->cmsg_type == IP_RECVERR)
+                    || (header->cmsg_level == SOL_IPV6 && header->cmsg_type == IPV6_RECVERR);
+                if(!recvErr){
+                    continue;
+                }
+                const sock_extended_err* extendedErr = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(header));
+                if(extendedErr->ee_errno != 0 || extendedErr->ee_origin != SO_EE_ORIGIN_ZEROCOPY){
+                    continue;
+                }
+                //the notification covers the sends [ee_info, ee_data]
+                if(extendedErr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED){
+                    copiedCount += extendedErr->ee_data - extendedErr->ee_info + 1;
+                }
+                complete(extendedErr->ee_info, extendedErr->ee_data);
+            }
+        }
+        return release();
+    }
+
+    void ZeroCopySender::flush(){
+        while(!pending.empty()){
+            if(pollCompletions() == 0){
+                waitCompletions();
+            }
+        }
+    }
+
+    bool ZeroCopySender::isZeroCopyEnabled() const noexcept{
+        return zeroCopy;
+    }
+
+    std::size_t ZeroCopySender::getPendingCount() const noexcept{
+        return pending.size();
+    }
+
+    std::size_t ZeroCopySender::getCopiedCount() const noexcept{
+        return copiedCount;
+    }
+
+    void ZeroCopySender::complete(std::uint32_t first, std::uint32_t last){
+        for(PendingBuffer& buffer : pending){
+            if(buffer.sends == 0){
+                continue;
+            }
+            //the sequence numbers wrap, use the signed distances from the first send of the buffer
+            std::int64_t overlapFirst = std::max<std::int64_t>(static_cast<std::int32_t>(first - buffer.first), 0);
+            std::int64_t overlapLast = std::min<std::int64_t>(static_cast<std::int32_t>(last - buffer.first), buffer.sends - 1);
+            if(overlapFirst <= overlapLast){
+                buffer.remaining -= std::min<std::uint32_t>(buffer.remaining, static_cast<std::uint32_t>(overlapLast - overlapFirst + 1));
+            }
+        }
+    }
+
+    std::size_t ZeroCopySender::release(){
+        //the callbacks run after the list is updated, they may send again
+        std::vector<ReleaseCallback> released;
+        for(auto bufferIt = pending.begin(); bufferIt != pending.end();){
+            if(bufferIt->queued && bufferIt->remaining == 0){
+                released.push_back(std::move(bufferIt->onRelease));
+                bufferIt = pending.erase(bufferIt);
+            }else{
+                ++bufferIt;
+            }
+        }
+        for(ReleaseCallback& onRelease : released){
+            if(onRelease){
+                onRelease();
+            }
+        }
+        return released.size();
+    }
+
+    void ZeroCopySender::waitCompletions(){
+        //a non empty error queue is reported as POLLERR, which needs no request
+        pollfd pollFd{};
+        pollFd.fd = strSock.getFd();
+        while(::poll(&pollFd, 1, -1) == -1){
+            if(errno != EINTR){
+                throw SnlException("ZeroCopySender error: ", errno);
+            }
+        }
+    }
+}
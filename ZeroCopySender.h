@@ -0,0 +1,94 @@
+#ifndef ZEROCOPYSENDER_H
+#define ZEROCOPYSENDER_H
+//c headers
+//cpp headers
+#include <cstdint>
+#include <deque>
+#include <functional>
+//own headers
+
+namespace snl{
+
+    //forward declarations
+    class StreamSocket;
+
+    /**
+     * Sends large buffers with MSG_ZEROCOPY: the kernel sends straight from the user pages instead of copying them
+     * the buffer must then stay untouched until the kernel reports the send as complete on the error queue of the
+     * socket, the release callback of the buffer tells when that happened.
+     * Buffers below the threshold (and every buffer if the kernel does not support SO_ZEROCOPY) are copied as usual
+     * and released immediately.
+     * note: zero copy only pays off for large sends (the kernel documentation suggests above ~10 KiB), on loopback
+     *       the kernel always falls back to copying (counted in getCopiedCount)
+     * note: the socket must be connected and blocking, like for sendBuff
+     */
+    class ZeroCopySender
+    {
+    public:
+
+        //called once the buffer may be reused or freed
+        using ReleaseCallback = std::function<void()>;
+
+        static constexpr std::size_t defaultThreshold = 16 * 1024;
+
+        /**
+         * @brief enables SO_ZEROCOPY on the socket (falls back to copying if the kernel refuses)
+         * @param strSock the socket to send on, must outlive the sender
+         * @param threshold the minimum buffer size sent with zero copy
+         */
+        explicit ZeroCopySender(StreamSocket& strSock, std::size_t threshold = defaultThreshold);
+        ~ZeroCopySender(); //the buffers still in flight are not released, call flush first
+
+        ZeroCopySender(const ZeroCopySender& rhs) = delete;
+        ZeroCopySender& operator=(const ZeroCopySender& rhs) = delete;
+
+        /**
+         * @brief sends the complete buffer
+         * @param onRelease called once the buffer may be reused: immediately for a copied send, else from
+         *        a later call to pollCompletions, flush or send
+         * note: blocks until the whole buffer is queued in the kernel, not until it is released
+         */
+        void send(const void* buffer, std::size_t bufferSize, ReleaseCallback onRelease);
+
+        /**
+         * @brief reads the completions available on the error queue without blocking
+         * @return the number of buffers released
+         */
+        std::size_t pollCompletions();
+
+        /**
+         * @brief blocks until every buffer in flight is released
+         */
+        void flush();
+
+        bool isZeroCopyEnabled() const noexcept;
+        std::size_t getPendingCount() const noexcept;
+        std::size_t getCopiedCount() const noexcept; //zero copy sends the kernel had to copy anyway
+
+    private:
+
+        struct PendingBuffer{
+            std::uint32_t first = 0; //sequence number of the first send of the buffer
+            std::uint32_t sends = 0; //number of zero copy sends of the buffer
+            std::uint32_t remaining = 0; //sends not reported as complete yet
+            bool queued = false; //all the sends of the buffer are done
+            ReleaseCallback onRelease;
+        };
+
+        //marks the sends [first, last] as complete
+        void complete(std::uint32_t first, std::uint32_t last);
+        //releases the queued buffers without sends in flight, returns the number of buffers released
+        std::size_t release();
+        //blocks until the error queue is readable
+        void waitCompletions();
+
+        StreamSocket& strSock;
+        std::size_t threshold;
+        bool zeroCopy = false;
+        std::uint32_t nextSequence = 0; //the kernel numbers the zero copy sends of a socket from 0
+        std::deque<PendingBuffer> pending;
+        std::size_t copiedCount = 0;
+    };
+}
+
+#endif // ZEROCOPYSENDER_H
@@ -9,6 +9,8 @@
 #include "ServerSocket.h"
 #include "TcpPort.h"
 #include "StreamSocket.h"
+#include "BufferPool.h"
+#include "RecordSplitter.h"
 
 //test function declaration
 void snlExceptionTest();
@@ -16,10 +18,12 @@ void ipStringTest();
 void servSockFsmTest();
 void strSockTest(const std::string&);
 void serverFunc(std::size_t);
+void recordSplitterTest();
 
 int main(int argc, char **argv)
 {
     std::string msg("hello there! i hope this message comes trough... otherwise i would be sad :(");
+    recordSplitterTest();
     servSockFsmTest();
     //serverFunc(msg.size());
 
@@ -35,7 +39,8 @@ void serverFunc(std::size_t dataToRead){
 //    sock.listen();
     snl::StreamSocket strSock = sock.accept();
     
-    char buffer[dataToRead +1];
+    snl::PooledBuffer pooled = snl::BufferPool::getDefault().acquire(dataToRead + 1);
+    char* buffer = pooled.data();
     std::size_t dataRead = 0;
     do{
         dataRead += snl::receiveBuff(strSock, (&buffer[dataRead]), dataToRead - dataRead);
@@ -128,3 +133,44 @@ void snlExceptionTest(){
     }
 }
 
+void recordSplitterTest(){
+    
+    std::cout << "____record splitter test____" << std::endl;
+    
+    //every vector kernel must find the same offsets as the scalar one, the delimiters are placed on and across
+    //the 16 and 32 byte chunk boundaries (and at the very end, the tail of the vector loops)
+    std::vector<snl::SearchKernel> kernels{snl::SearchKernel::SSE2, snl::SearchKernel::AVX2};
+    for(std::string delim : {"\n", "\r\n"}){
+        for(std::size_t size = 0; size != 100; size++){
+            for(std::size_t at : {0, 14, 15, 16, 30, 31, 32, 47, 63, 64, 97}){
+                std::string block(size, 'a');
+                if(at + delim.size() <= size){
+                    block.replace(at, delim.size(), delim);
+                }
+                if(size >= delim.size()){
+                    block.replace(size - delim.size(), delim.size(), delim);
+                }
+                std::vector<std::size_t> expected;
+                snl::findDelimiters(block, delim, expected, snl::SearchKernel::SCALAR);
+                for(snl::SearchKernel kernel : kernels){
+                    std::vector<std::size_t> offsets;
+                    snl::findDelimiters(block, delim, offsets, kernel);
+                    assert(offsets == expected);
+                }
+            }
+        }
+    }
+    
+    //a delimiter split over two blocks
+    snl::RecordSplitter splitter;
+    std::string first = std::string(31, 'x') + "\r";
+    assert(splitter.split(first).empty());
+    const std::vector<std::string_view>& records = splitter.split("\nnext\r\n");
+    assert(records.size() == 2 && records[0] == std::string(31, 'x') && records[1] == "next");
+    
+    //the records in front of an oversized record are not lost
+    snl::RecordSplitter limited("\r\n", 8);
+    assert(limited.split("ab\r\ncd\r\n0123456789").size() == 2);
+    assert(limited.getOversizedRecords() == 1);
+    assert(limited.split("9\r\nok\r\n").size() == 1);
+}